@@ -73,10 +73,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //---------------------------------------------------------------------------
 
 #include <string.h>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include<vector>
+#include <algorithm>
 #include <chrono>
+#include <sstream>
 
 // Disable specific MSVC warnings that are unavoidable in ALMaSS framework
 #pragma warning( push )
@@ -93,6 +96,24 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../BatchALMaSS/AOR_Probe.h"
 #include "../Osmia/Osmia.h"
 #include "../Osmia/Osmia_Population_Manager.h"
+#ifdef OSMIA_CLIMATE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>   // getpid() for unique temporary file names
+#elif defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>  // MoveFileExA() to replace a file in one step
+#include <process.h>  // _getpid()
+#endif
 
 //==============================================================================
 // CONFIGURATION PARAMETERS (Static initialization)
@@ -370,6 +391,22 @@ static CfgArray_Double cfg_OsmiaParasDispersal("OSMIA_PARAS_DISPERSAL", CFG_CUST
 static CfgArray_Double cfg_OsmiaParasStartHighLow("OSMIA_PARAS_STARTHIGHLOW", CFG_CUSTOM, 
 	2*(static_cast<unsigned>(TTypeOfOsmiaParasitoids::topara_foobar) - 1), vector<double> { 2.0, 1.0, 2.0, 1.0});
 
+/**
+ * @var cfg_OsmiaParasMacroStep
+ * @brief Enable closed-form macro-stepping of the parasitoid grid on host-free days
+ * 
+ * @details When true, days with no active *Osmia* hosts (after the flying season and
+ * before spring emergence) are not simulated cell by cell. Mortality and dispersal over
+ * the whole interval are applied in one pass when hosts become active again (see
+ * OsmiaParasitoid_Population_Manager::Synchronise()).
+ * 
+ * @par Default: false
+ * Daily simulation of every cell, as before. Switching on gives the same expected
+ * densities to rounding, but replaces hundreds of daily sub-population updates per
+ * simulated winter with one scalar decay and a tight stencil loop per skipped day.
+ */
+static CfgBool cfg_OsmiaParasMacroStep("OSMIA_PARAS_MACROSTEP", CFG_CUSTOM, false);
+
 /**
  * @var cfg_OsmiaAdultMassCategoryStep
  * @brief Step size for discretizing adult female mass into categories
@@ -410,8 +447,9 @@ CfgFloat cfg_OsmiaAdultMassCategoryStep("OSMIA_ADULTMASSCLASSSTEP", CFG_CUSTOM,
  * @var cfg_OsmiaNestByLE_Datafile
  * @brief Filename for nest density by landscape element data
  * 
- * @details Input file specifying nesting suitability/capacity for each habitat type.
- * Format typically: LE_ID, max_nests_per_hectare, nesting_probability
+ * @details Input file specifying nesting suitability/capacity for each habitat type, one
+ * `type max_nests_per_hectare nesting_probability` line per type
+ * (see Osmia_Nest_Manager::ReadNestsByHabitat()).
  * 
  * @par Usage
  * Read during nest manager initialization to populate polygon-level nesting parameters.
@@ -421,6 +459,205 @@ CfgFloat cfg_OsmiaAdultMassCategoryStep("OSMIA_ADULTMASSCLASSSTEP", CFG_CUSTOM,
  */
 static CfgStr cfg_OsmiaNestByLE_Datafile("OSMIA_NESTBYLEDATAFILE", CFG_CUSTOM, "OsmiaNestsByHabitat.txt");
 
+/**
+ * @var cfg_OsmiaParameterBundle
+ * @brief Filename of the compiled binary parameter bundle
+ * 
+ * @details If set, Init() loads the parameter and lookup tables from this file when it is
+ * intact and matches the current text inputs, and otherwise builds them from text and
+ * (re)writes the file. Intended for large batches of runs sharing one parameterisation.
+ * 
+ * @par Default: "" (disabled, tables always built from text)
+ * 
+ * @see OsmiaParameterBundle
+ */
+static CfgStr cfg_OsmiaParameterBundle("OSMIA_PARAMETERBUNDLE", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaRasterInterval
+ * @brief Days between spatial raster snapshots (nests, brood, females, parasitoids)
+ * @details 0 disables raster output and its incremental counting. Use 7 for weekly maps.
+ * @par Default: 0
+ * @see OsmiaRasterOutput
+ */
+static CfgInt cfg_OsmiaRasterInterval("OSMIA_RASTER_INTERVAL", CFG_CUSTOM, 0);
+
+/**
+ * @var cfg_OsmiaRasterCellSize
+ * @brief Raster cell size in metres
+ * @par Default: 100
+ */
+static CfgInt cfg_OsmiaRasterCellSize("OSMIA_RASTER_CELLSIZE", CFG_CUSTOM, 100);
+
+/**
+ * @var cfg_OsmiaRasterPrefix
+ * @brief File name prefix for raster snapshots (the day number and .orst are appended)
+ */
+static CfgStr cfg_OsmiaRasterPrefix("OSMIA_RASTER_PREFIX", CFG_CUSTOM, "OsmiaRaster");
+
+/**
+ * @var cfg_OsmiaMicroclimate
+ * @brief Use nest-specific microclimate temperatures for brood development
+ * @details When false every nest develops at the landscape temperature, as in the original
+ * model. When true, aspect acts through the class temperatures and the nest aspect delay is no
+ * longer added to the spring emergence counter. Default false.
+ * @see OsmiaDailyEnvironment
+ */
+static CfgBool cfg_OsmiaMicroclimate("OSMIA_MICROCLIMATE", CFG_CUSTOM, false);
+
+/**
+ * @var cfg_OsmiaMicroclimateOffsets
+ * @brief Nest temperature offset from the landscape temperature by microclimate class (°C)
+ * @details Six values in class order: warm, neutral and cool aspect in open habitat, then the
+ * same three in shaded habitat.
+ *
+ * @par Uncertainty
+ * HIGH - Illustrative values. Trap nest temperatures depend strongly on substrate and exposure;
+ * these should be calibrated against logged nest temperatures before use.
+ */
+static CfgArray_Double cfg_OsmiaMicroclimateOffsets("OSMIA_MICROCLIMATE_OFFSETS", CFG_CUSTOM, OSMIA_MICROCLIMATE_CLASSES,
+	vector<double> { 1.0, 0.0, -1.0, 0.0, -1.0, -2.0 });
+
+/**
+ * @var cfg_OsmiaMicroclimateAspectCuts
+ * @brief Aspect delay limits (days) separating the warm, neutral and cool aspect bands
+ * @details Nests with an aspect delay below the first value are warm, above the second cool.
+ */
+static CfgArray_Double cfg_OsmiaMicroclimateAspectCuts("OSMIA_MICROCLIMATE_ASPECTCUTS", CFG_CUSTOM, 2,
+	vector<double> { 1.0, 3.0 });
+
+/**
+ * @var cfg_OsmiaClimateStreamFile
+ * @brief Binary climate file supplying temperature and flying hours to the Osmia model
+ * @details If set, the daily temperature and pre-wintering temperature history come from this
+ * file instead of the landscape weather, and so do the flying hours if the file was made from
+ * hourly input. The first record is taken as 1 January of the first simulated year, and the
+ * file must cover the whole run. Default "" (landscape weather).
+ * @see OsmiaClimateStream
+ */
+static CfgStr cfg_OsmiaClimateStreamFile("OSMIA_CLIMATE_STREAM_FILE", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaClimateStreamSource
+ * @brief Weather text file converted to OSMIA_CLIMATE_STREAM_FILE when that file cannot be opened
+ * @details Default "" (no conversion; the binary file must already exist).
+ */
+static CfgStr cfg_OsmiaClimateStreamSource("OSMIA_CLIMATE_STREAM_SOURCE", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaClimateStreamSourceHourly
+ * @brief OSMIA_CLIMATE_STREAM_SOURCE has an hour column (year month day hour temperature wind rain)
+ * @details Default false (daily rows of year month day temperature wind rain). A stream made from
+ * daily rows supplies temperature only; flying hours then come from the landscape weather.
+ */
+static CfgBool cfg_OsmiaClimateStreamSourceHourly("OSMIA_CLIMATE_STREAM_SOURCE_HOURLY", CFG_CUSTOM, false);
+
+/**
+ * @var cfg_OsmiaClimateStreamWindow
+ * @brief Number of days of climate records held in memory at once. Default 366.
+ */
+static CfgInt cfg_OsmiaClimateStreamWindow("OSMIA_CLIMATE_STREAM_WINDOW", CFG_CUSTOM, 366);
+
+/**
+ * @var cfg_OsmiaSpeciesFile
+ * @brief Traits file of further solitary bee species simulated alongside *O. bicornis*
+ * @details Default "" (*O. bicornis* only). Format described for OsmiaSpeciesTraits.
+ */
+static CfgStr cfg_OsmiaSpeciesFile("OSMIA_SPECIES_FILE", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaReserveLookahead
+ * @brief Days ahead covered when reserving stage list capacity
+ * @details Each morning every stage list is grown to hold the largest count expected over
+ * this many days, so lists are not reallocated and copied in the middle of a step.
+ * Reservation costs a daily pass over the females and keeps peak-sized lists allocated all
+ * year, so it is only worth enabling where profiling shows list growth in the step.
+ * @par Default: 0 (no reservation; lists grow as before)
+ * @see Osmia_Population_Manager::ReserveStageCapacity()
+ */
+static CfgInt cfg_OsmiaReserveLookahead("OSMIA_RESERVE_LOOKAHEAD", CFG_CUSTOM, 0);
+
+/**
+ * @var cfg_OsmiaReserveHeadroom
+ * @brief Multiplier applied to the predicted stage count when reserving capacity
+ * @details Covers year-to-year growth of the population. Default 1.25.
+ */
+static CfgFloat cfg_OsmiaReserveHeadroom("OSMIA_RESERVE_HEADROOM", CFG_CUSTOM, 1.25);
+
+#ifdef __OSMIA_LINEAGE
+/**
+ * @var cfg_OsmiaRecordLineage
+ * @brief Record mother-offspring links for every egg laid
+ * @details Only available when compiled with __OSMIA_LINEAGE. Default false.
+ * @see OsmiaLineageLog
+ */
+static CfgBool cfg_OsmiaRecordLineage("OSMIA_RECORD_LINEAGE", CFG_CUSTOM, false);
+
+/**
+ * @var cfg_OsmiaLineageFile
+ * @brief Binary output file for the lineage log
+ */
+static CfgStr cfg_OsmiaLineageFile("OSMIA_LINEAGE_FILE", CFG_CUSTOM, "OsmiaLineage.bin");
+#endif // __OSMIA_LINEAGE
+
+#ifdef __OSMIA_METRICS
+/**
+ * @var cfg_OsmiaMetricsFile
+ * @brief Prometheus text file receiving live run metrics
+ * @details Rewritten atomically at the end of each publishing day. Default "" (no export).
+ * @see OsmiaMetricsExporter
+ */
+static CfgStr cfg_OsmiaMetricsFile("OSMIA_METRICS_FILE", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaMetricsInterval
+ * @brief Days between metrics snapshots
+ * @par Default: 1
+ */
+static CfgInt cfg_OsmiaMetricsInterval("OSMIA_METRICS_INTERVAL", CFG_CUSTOM, 1);
+#endif // __OSMIA_METRICS
+
+#ifdef __OSMIATESTING
+/**
+ * @var cfg_OsmiaEquivOutput
+ * @brief File receiving this run's raw samples for the equivalence harness
+ * @details Use a distinct name per seed. Default "" (samples not written).
+ * @see OsmiaEquivalenceHarness
+ */
+static CfgStr cfg_OsmiaEquivOutput("OSMIA_EQUIV_OUTPUT", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaEquivEngine
+ * @brief Engine tag written into the sample file (e.g. "reference" or "optimised")
+ */
+static CfgStr cfg_OsmiaEquivEngine("OSMIA_EQUIV_ENGINE", CFG_CUSTOM, "reference");
+
+/**
+ * @var cfg_OsmiaEquivReference
+ * @brief Space-separated list of reference-engine sample files to compare
+ */
+static CfgStr cfg_OsmiaEquivReference("OSMIA_EQUIV_REFERENCE", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaEquivCandidate
+ * @brief Space-separated list of candidate-engine sample files to compare
+ */
+static CfgStr cfg_OsmiaEquivCandidate("OSMIA_EQUIV_CANDIDATE", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaEquivReport
+ * @brief Report file for the comparison. Default "" (no comparison made)
+ */
+static CfgStr cfg_OsmiaEquivReport("OSMIA_EQUIV_REPORT", CFG_CUSTOM, "");
+
+/**
+ * @var cfg_OsmiaEquivAlpha
+ * @brief Family-wise significance level for the equivalence tests
+ * @par Default: 0.05 (Bonferroni-corrected across metrics)
+ */
+static CfgFloat cfg_OsmiaEquivAlpha("OSMIA_EQUIV_ALPHA", CFG_CUSTOM, 0.05);
+#endif // __OSMIATESTING
+
 /**
  * @var cfg_OsmiaFemaleBckMort
  * @brief Daily background mortality for adult females
@@ -1259,6 +1496,33 @@ static CfgFloat cfg_OsmiaMaxPrecipForFlying("OSMIA_MAX_PRECIP_FOR_FLYING", CFG_C
  */
 static CfgFloat cfg_OsmiaOverwinterDegreeDaysInitialSimu("OSMIA_OVERWINTER_DEGREE_DAYS_INITIAL_SIMU", CFG_CUSTOM, 320);
 
+/**
+ * @var cfg_OsmiaForageRangeClasses
+ * @brief Number of body-size foraging range classes
+ *
+ * @details Females forage within a range that grows with body mass. The range is quantised into
+ * this many classes, each a distance-sorted prefix of the detailed forage mask
+ * (OsmiaForageMaskCatalogue).
+ *
+ * @par Default: 1
+ * A single class gives every female the whole detailed mask, the behaviour without the size
+ * effect. Eight classes resolve the mass range well enough for the R50 data.
+ */
+static CfgInt cfg_OsmiaForageRangeClasses("OSMIA_FORAGE_RANGE_CLASSES", CFG_CUSTOM, 1, 1, 64);
+
+/**
+ * @var cfg_OsmiaForageRangeMassExponent
+ * @brief Allometric exponent of foraging range on female mass
+ *
+ * @details A female's range is the species' typical homing distance scaled by
+ * (mass / mid-range mass) raised to this exponent, then limited by the maximum homing distance.
+ *
+ * @par Default: 1.0
+ * Foraging distance rises roughly with the cube of intertegular span (Greenleaf et al. 2007),
+ * and mass with the cube of span, giving a near-linear relation with mass.
+ */
+static CfgFloat cfg_OsmiaForageRangeMassExponent("OSMIA_FORAGE_RANGE_MASS_EXPONENT", CFG_CUSTOM, 1.0);
+
 //==============================================================================
 // EXTERNAL CONFIGURATION REFERENCES
 //==============================================================================
@@ -1303,6 +1567,9 @@ double Osmia_Base::m_OsmiaFemaleMassFromProvMassConst = 0.0;
 double Osmia_Base::m_OsmiaFemaleMassFromProvMassSlope = 0.0;
 double Osmia_Base::m_TempToday = -9999;
 int Osmia_Base::m_TempTodayInt = -9999;
+OsmiaDailyEnvironment Osmia_Base::m_Environment;
+OsmiaSpeciesTraits Osmia_Base::m_SpeciesTraits[OSMIA_MAX_SPECIES];
+int Osmia_Base::m_NoSpecies = 1;
 OsmiaParasitoid_Population_Manager* Osmia_Base::m_OurParasitoidPopulationManager = NULL;
 double Osmia_InCocoon::m_OverwinteringTempThreshold = 0.0;
 double Osmia_Base::m_OsmiaFemaleBckMort = 0.0;
@@ -1315,6 +1582,7 @@ double Osmia_Base::m_TotalProvisioningMassLoss = 0.0;
 double Osmia_Base::m_TotalProvisioningMassLossRange = 0.0;
 double Osmia_Base::m_TotalProvisioningMassLossRangeX2 = 0.0;
 bool Osmia_Base::m_UsingMechanisticParasitoids = false;
+const TTypeOfOsmiaState Osmia_Base::m_DevelopOutcome[2][2] = { { toOsmias_Develop, toOsmias_NextStage }, { toOsmias_Die, toOsmias_Die } };
 double Osmia_Base::m_PollenScoreToMg = 0.0;
 double Osmia_Base::m_DensityDependentPollenRemovalConst = 0.0;
 double Osmia_Base::m_MaleMinTargetProvisionMass = 0.0;
@@ -1335,13 +1603,19 @@ int Osmia_Base::m_OsmiaFemaleLifespan = 0;
 int Osmia_Base::m_OsmiaFemalePrenesting = 0;
 vector<double> Osmia_Base::m_ParasitoidAttackChance = {};
 Osmia_Nest_Manager* Osmia_Nest::m_OurManager = NULL;
+#ifdef __OSMIA_METRICS
+double Osmia_Nest::m_LockWaitSeconds = 0.0;
+unsigned long Osmia_Nest::m_LockedTransfers = 0;
+#endif
 array<double,12> OsmiaParasitoidSubPopulation::m_MortalityPerMonth = { 0,0,0,0,0,0,0,0,0,0,0,0 };
 int OsmiaParasitoidSubPopulation::m_ThisMonth = -1;
-vector<double> Osmia_Female::m_FemaleForageEfficiency = {};
+OsmiaAgeTable Osmia_Female::m_FemaleForageEfficiency;
 double Osmia_Female::m_pollengiveupthreshold = 0.0;
 double Osmia_Female::m_pollengiveupreturn = 0.0;
 OsmiaForageMask Osmia_Female::m_foragemask;
 OsmiaForageMaskDetailed Osmia_Female::m_foragemaskdetailed(1,600);
+OsmiaForageMaskCatalogue Osmia_Female::m_foragemaskcatalogue;
+double Osmia_Female::m_ForageRangeMassExponent = 1.0;
 int Osmia_Female::m_ForageSteps = 20;
 double Osmia_Female::m_PollenCompetitionsReductionScaler = cfg_OsmiaDensityDependentPollenRemovalConst.value();
 
@@ -1394,6 +1668,9 @@ extern CfgArray_Double cfg_pest_product_amounts;
  */
 Osmia_Population_Manager::~Osmia_Population_Manager (void)
 {
+#ifdef __OSMIA_LINEAGE
+	if (m_Lineage.IsOpen()) m_Lineage.Close();
+#endif
 #ifdef __OSMIATESTING
 	delete m_female_weight_record_lock;
 	m_eggsfirstnest.close();
@@ -1407,6 +1684,20 @@ Osmia_Population_Manager::~Osmia_Population_Manager (void)
 		      << m_egghistogram[3][i] << endl;
 	}
 	ofile.close();
+
+	// Equivalence harness: write this run's samples, then compare run sets if requested
+	string equivout = cfg_OsmiaEquivOutput.value();
+	if (!equivout.empty()) m_Equivalence.Write(equivout, cfg_OsmiaEquivEngine.value());
+	string equivreport = cfg_OsmiaEquivReport.value();
+	if (!equivreport.empty()) {
+		OsmiaEquivalenceHarness reference, candidate;
+		ofstream report(equivreport, ios::out);
+		if (reference.Read(cfg_OsmiaEquivReference.value()) && candidate.Read(cfg_OsmiaEquivCandidate.value())) {
+			OsmiaEquivalenceHarness::Compare(reference, candidate, cfg_OsmiaEquivAlpha.value(), report);
+		}
+		else report << "FAIL: could not read reference or candidate sample files" << endl;
+		report.close();
+	}
 #endif // __OSMIATESTING
 }
 
@@ -1474,14 +1765,15 @@ Osmia_Population_Manager::~Osmia_Population_Manager (void)
  * @par Population Initialization Details
  * 
  * **Mass Assignment**:
- * Mass drawn from uniform(cfg_OsmiaFemaleMassMin, cfg_OsmiaFemaleMassMax)
+ * Mass drawn from uniform(cfg_OsmiaFemaleMassMin, cfg_OsmiaFemaleMassMax), or from the female
+ * mass range of the founder's species when OSMIA_SPECIES_FILE adds further species
  * - Converts to internal mass class index: (mass - 4.0) / 0.25
  * - Full range creates realistic size distribution
  * - Affects fecundity, sex ratios, survival (size-dependent fitness)
  * 
  * **Spatial Placement**:
  * Random polygon from suitable_polygons list
- * - Within-polygon: random point via SupplyARandomLocPoly()
+ * - Within-polygon: random cell from the nest manager's run-length cell lists
  * - Nest created at that location
  * - Spatially heterogeneous (clustered in good habitat)
  * 
@@ -1548,11 +1840,10 @@ Osmia_Population_Manager::Osmia_Population_Manager(Landscape* L) : Population_Ma
 	m_PreWinteringEndFlag = true;
 	m_OverWinterEndFlag = false;
 
-	// Identify suitable nesting habitat
+	// Identify suitable nesting habitat (nest-capable polygons only, no full rescan)
 	std::vector<int> suitable_polygons;
 	m_OurOsmiaNestManager.UpdateOsmiaNesting();
-	int num_poly = m_TheLandscape->SupplyNumberOfPolygons();
-	for (int i = 0; i < num_poly; i++) {
+	for (int i : m_OurOsmiaNestManager.GetNestCapablePolygons()) {
 		if (IsOsmiaNestPossible(i)) {
 			suitable_polygons.push_back(i);
 		}
@@ -1571,9 +1862,11 @@ Osmia_Population_Manager::Osmia_Population_Manager(Landscape* L) : Population_Ma
 			sp->OPM = this;
 			sp->L = m_TheLandscape;
 			
-			// Assign random mass within configured range
-			double minmass = (cfg_OsmiaFemaleMassMin.value() - 4) / 0.25;
-			double maxmass = (cfg_OsmiaFemaleMassMax.value() - 4) / 0.25;
+			// Assign species (only drawn when several are simulated) and random mass within its range
+			sp->species = Osmia_Base::PickFounderSpecies();
+			const OsmiaSpeciesTraits& traits = Osmia_Base::GetSpeciesTraits(sp->species);
+			double minmass = (traits.m_FemaleMinMass - 4) / 0.25;
+			double maxmass = (traits.m_FemaleMaxMass - 4) / 0.25;
 			sp->mass = minmass + (maxmass - minmass) * g_rand_uni_fnc();
 			
 			sp->parasitised = TTypeOfOsmiaParasitoids::topara_Unparasitised;
@@ -1581,7 +1874,7 @@ Osmia_Population_Manager::Osmia_Population_Manager(Landscape* L) : Population_Ma
 
 			// Random placement in suitable habitat
 			int pindex = suitable_polygons[g_random_fnc(num_poly_for_nesting)];
-			APoint temp_point = m_TheLandscape->SupplyARandomLocPoly(pindex);
+			APoint temp_point = m_OurOsmiaNestManager.SupplyRandomLocation(pindex);
 			sp->x = temp_point.m_x;
 			sp->y = temp_point.m_y;
 			sp->nest = CreateNest(sp->x, sp->y, pindex);
@@ -1603,12 +1896,6 @@ Osmia_Population_Manager::Osmia_Population_Manager(Landscape* L) : Population_Ma
 	// Cache frequently-accessed parameters
 	m_PollenCompetitionsReductionScaler = cfg_OsmiaDensityDependentPollenRemovalConst.value();
 	
-	// Populate prepupal development rate lookup table
-	m_PrePupalDevelRates.resize(42);
-	for (int i = 0; i < 42; i++) {
-		m_PrePupalDevelRates[i] = cfg_OsmiaPrepupalDevelRates.value(i);
-	}
-	
 	// Enable parallel execution
 	m_is_paralleled = true;
 
@@ -1645,6 +1932,11 @@ Osmia_Population_Manager::Osmia_Population_Manager(Landscape* L) : Population_Ma
  * - Open output files for detailed tracking (eggsfirstnest.txt, OsmiaFemaleWeights.txt)
  * 
  * **Stage 2: Nest Manager Initialization**
+ * If cfg_OsmiaParameterBundle names a bundle that matches the current text inputs, the
+ * nest type tables and all lookup tables of Stages 5, 6 and 8 are loaded from it. Otherwise
+ * they are built from text by ReadNestsByHabitat() and BuildParameterTables(), and the bundle
+ * is rewritten (see OsmiaParameterBundle).
+ * 
  * Call m_OurOsmiaNestManager.InitOsmiaBeeNesting():
  * - Read nesting suitability data from cfg_OsmiaNestByLE_Datafile
  * - Populate polygon-level nesting parameters (max nests, probabilities)
@@ -1744,9 +2036,10 @@ Osmia_Population_Manager::Osmia_Population_Manager(Landscape* L) : Population_Ma
  * ```
  * 
  * **Foraging efficiency lookup**:
- * Populate Osmia_Female::m_FemaleForageEfficiency[0-100]:
+ * Populate Osmia_Female::m_FemaleForageEfficiency[0-364]:
  * - Age 0: efficiency = 0 (newly-emerged, not foraging)
- * - Ages 1-100: Same Seidelmann (2006) efficiency equation as provisioning time
+ * - Ages 1-364: Same Seidelmann (2006) efficiency equation as provisioning time
+ * Reads beyond age 364 clamp to the last entry.
  * 
  * Used by females to calculate daily pollen collection given available foraging hours.
  * 
@@ -1755,9 +2048,9 @@ Osmia_Population_Manager::Osmia_Population_Manager(Landscape* L) : Population_Ma
  * - Sex ratio: 96 × 61 × 8 bytes ≈ 47 KB
  * - Cocoon mass: 96 × 61 × 8 bytes ≈ 47 KB
  * - Provisioning parameters: 365 × 8 bytes ≈ 3 KB
- * - Foraging efficiency: 101 × 8 bytes ≈ 1 KB
+ * - Foraging efficiency: 365 × 8 bytes ≈ 3 KB
  * - Prepupal rates: 42 × 8 bytes ≈ 0.3 KB
- * **Total: ~98 KB per population manager**
+ * **Total: ~100 KB per population manager**
  * 
  * Trivial memory cost (<0.1 MB) for massive computational savings (avoid millions
  * of exp/log evaluations during simulation).
@@ -1798,16 +2091,58 @@ void Osmia_Population_Manager::Init()
 	ofile.close();
 #endif
 	
+	// Parameter and lookup tables: from the binary bundle if it is current, otherwise from text
+	string bundlefile = cfg_OsmiaParameterBundle.value();
+	OsmiaParameterBundle bundle;
+	bool bundled = false;
+	uint64_t fingerprint = 0;
+	if (!bundlefile.empty()) {
+		fingerprint = ComputeParameterFingerprint();
+		bundled = bundle.Load(bundlefile, fingerprint) && ApplyParameterBundle(bundle);
+	}
+	if (!bundled) {
+		m_OurOsmiaNestManager.ReadNestsByHabitat();
+		BuildParameterTables();
+		if (!bundlefile.empty()) {
+			CaptureParameterBundle(bundle);
+			bundle.Save(bundlefile, fingerprint);
+		}
+	}
+	
 	// Initialize nest manager
 	m_OurOsmiaNestManager.InitOsmiaBeeNesting();
 	
 	// Set Egg stage parameters
 	Osmia_Egg::SetParameterValues();
-	Osmia_Egg::SetParasitoidManager(
-		static_cast<OsmiaParasitoid_Population_Manager*>(
-			this->m_TheLandscape->SupplyThePopManagerList()->GetPopulation(TOP_OsmiaParasitoids)
-		)
+	string speciesfile = cfg_OsmiaSpeciesFile.value();
+	if (speciesfile != "") {
+		string error;
+		if (!Osmia_Base::ReadSpeciesTraits(speciesfile, error)) {
+			m_TheLandscape->Warn("Osmia_Population_Manager::Init()", error);
+			std::exit(TOP_Osmia);
+		}
+	}
+	m_OurParasitoidPopulationManager = static_cast<OsmiaParasitoid_Population_Manager*>(
+		this->m_TheLandscape->SupplyThePopManagerList()->GetPopulation(TOP_OsmiaParasitoids)
 	);
+	Osmia_Egg::SetParasitoidManager(m_OurParasitoidPopulationManager);
+	if (m_OurParasitoidPopulationManager != NULL) {
+		m_OurParasitoidPopulationManager->ResetThreadBuffers(omp_get_max_threads());
+	}
+	m_OurOsmiaNestManager.ResetCellDeathQueues(omp_get_max_threads());
+	for (int st = 0; st <= int(TTypeOfOsmiaLifeStages::to_OsmiaFemale); st++) m_StageCountHistory[st].assign(366, 0);
+#ifdef __OSMIA_LINEAGE
+	if (cfg_OsmiaRecordLineage.value()) {
+		string lineagefile = cfg_OsmiaLineageFile.value();
+		if (!m_Lineage.Open(lineagefile, omp_get_max_threads())) {
+			m_TheLandscape->Warn("Osmia_Population_Manager::Init()", "cannot open lineage file " + lineagefile);
+		}
+	}
+#endif
+#ifdef __OSMIA_METRICS
+	string metricsfile = cfg_OsmiaMetricsFile.value();
+	m_Metrics.SetOutput(metricsfile, cfg_OsmiaMetricsInterval.value());
+#endif
 	
 	// Set InCocoon stage parameters
 	Osmia_InCocoon::SetOverwinteringTempThreshold(cfg_OsmiaInCocoonOverwinteringTempThreshold.value());
@@ -1828,6 +2163,7 @@ void Osmia_Population_Manager::Init()
 	Osmia_Female::SetNestFindAttempts(cfg_OsmiaFemaleFindNestAttemptNo.value());
 	Osmia_Female::SetForageSteps(cfg_OsmiaForageSteps.value());
 	Osmia_Female::SetForageMaskDetailed(cfg_OsmiaDetailedMaskStep.value(), cfg_OsmiaTypicalHomingDistance.value());
+	Osmia_Female::SetForageRangeClasses(cfg_OsmiaForageRangeClasses.value(), cfg_OsmiaForageRangeMassExponent.value());
 	Osmia_Female::SetPollenGiveUpThreshold(cfg_OsmiaPollenGiveUpThreshold.value());
 	Osmia_Female::SetPollenGiveUpReturn(cfg_OsmiaPollenGiveUpReturn.value());
 	
@@ -1849,66 +2185,6 @@ void Osmia_Population_Manager::Init()
 	Osmia_Female::m_OsmiaPPPOversprayChance = cfg_OsmiaPesticideOversprayChance.value();
 #endif
 	
-	// Read monthly pollen and nectar thresholds
-	OsmiaPollenNectarThresholds pnt;
-	for (int m = 0; m < 12; m++) {
-		pnt.m_pollenTquan = cfg_OsmiaPollenThresholds.value(m);
-		pnt.m_pollenTqual = cfg_OsmiaPollenThresholds.value(m + 12);
-		pnt.m_nectarTquan = cfg_OsmiaNectarThresholds.value(m);
-		pnt.m_nectarTqual = cfg_OsmiaNectarThresholds.value(m + 12);
-		m_PN_thresholds.push_back(pnt);
-	}
-	
-	// Build sex ratio and cocoon mass lookup tables
-	vector<double> params_logistic, params_lin, params_logistic2, params_lin2;
-	params_logistic = cfg_OsmiaSexRatioVsMotherAgeLogistic.value();
-	params_lin = cfg_OsmiaSexRatioVsMotherMassLinear.value();
-	params_lin2 = Cfg_OsmiaFemaleCocoonMassVsMotherMassLinear.value();
-	params_logistic2 = Cfg_OsmiaFemaleCocoonMassVsMotherAgeLogistic.value();
-	
-	eggsexratiovsagelogisticcurvedata curve1;
-	femalecocoonmassvsagelogisticcurvedata curve2;
-	
-	// Note: Uses 0.25 mg step despite cfg_OsmiaAdultMassCategoryStep = 10.0
-	for (double mass = cfg_OsmiaFemaleMassMin.value(); 
-	     mass <= cfg_OsmiaFemaleMassMax.value(); 
-	     mass += 0.25) {  // HARDCODED step size (not from config!)
-		
-		for (unsigned age = 0; age <= 60; age++) {
-			// Sex ratio calculation: Logistic(age, adjusted_max)
-			double adjustedmax = params_lin[0] * mass + params_lin[1];
-			double sex_ratio = params_logistic[1] + 
-			                   (adjustedmax - params_logistic[1]) / 
-			                   (1 + exp(-params_logistic[3] * (age - params_logistic[0])));
-			curve1.push_back(sex_ratio);
-			
-			// Cocoon mass calculation: Logistic(age, mass-adjusted baseline)
-			double avg_female_cocoon_mass = params_lin2[0] * mass + params_lin2[1];
-			double first_female_cocoon_mass = avg_female_cocoon_mass + 
-			                                   cfg_Osmia_LifetimeCocoonMassLoss.value() / 2.0;
-			
-			// Convert to provisioning mass
-			double prov_mass = 40.0 + (cfg_OsmiaProvMassFromCocoonMass.value() * 
-			                   (params_logistic2[1] + 
-			                    (first_female_cocoon_mass - params_logistic2[1]) / 
-			                    (1 + exp(-params_logistic2[3] * (age - params_logistic2[0])))));
-			curve2.push_back(prov_mass);
-		}
-		
-		m_EggSexRatioEqns.push_back(curve1);
-		m_FemaleCocoonMassEqns.push_back(curve2);
-		curve1.clear();
-		curve2.clear();
-	}
-	
-	// Build provisioning time lookup table
-	for (int d = 0; d < 365; d++) {
-		// Seidelmann (2006) provisioning efficiency equation
-		double eff = 21.643 / (1 + pow(exp(1.0), (log(d) - log(18.888)) * 3.571));  // mg/h
-		double constructime = (2.576 * eff + 56.17) / eff;  // hours per cell
-		m_NestProvisioningParameters[d] = int(constructime);
-	}
-	
 	// Set parasitoid parameters
 	Osmia_Female::SetParasitoidParameters(cfg_OsmiaPerCapitaParasationChance.value());
 	
@@ -1917,12 +2193,24 @@ void Osmia_Population_Manager::Init()
 	int GEy = SimH / 1000;
 	m_FemaleDensityGrid.resize(m_GridExtent * GEy);
 	ClearDensityGrid();
-	
-	// Build foraging efficiency lookup table
-	Osmia_Female::AddForageEfficiency(0);  // Age 0: no foraging
-	for (int i = 1; i <= 100; i++) {
-		double eff = 21.643 / (1 + exp((log(i) - log(18.888)) * 3.571));
-		Osmia_Female::AddForageEfficiency(eff);
+
+	// Spatial output rasters (must exist before the initial population is created)
+	m_Raster.Init(SimW, SimH, (cfg_OsmiaRasterInterval.value() > 0) ? cfg_OsmiaRasterCellSize.value() : 0);
+
+	// Streaming climate input, converted from the weather text file if necessary
+	string climatefile = cfg_OsmiaClimateStreamFile.value();
+	if (!climatefile.empty()) {
+		string climatesource = cfg_OsmiaClimateStreamSource.value();
+		bool hourly = cfg_OsmiaClimateStreamSourceHourly.value();
+		unsigned window = unsigned(max(cfg_OsmiaClimateStreamWindow.value(), 1));
+		// Reconvert if the file is missing or was made from input of the other format
+		if (!m_Climate.Open(climatefile, window) || (!climatesource.empty() && m_Climate.HasHours() != hourly)) {
+			if (climatesource.empty() || !OsmiaClimateStream::Convert(climatesource, climatefile, hourly) || !m_Climate.Open(climatefile, window)) {
+				m_TheLandscape->Warn("Osmia_Population_Manager::Init()", "cannot open climate stream " + climatefile);
+				std::exit(TOP_Osmia);
+			}
+		}
+		m_Climate.SetFlyingThresholds(cfg_OsmiaMinTempForFlying.value(), cfg_OsmiaMaxWindSpeedForFlying.value(), cfg_OsmiaMaxPrecipForFlying.value());
 	}
 	
 	// Reset testing output file
@@ -1953,10 +2241,9 @@ void Osmia_Population_Manager::Init()
  * 1. **Allocate object**: new Osmia_XXX(data)
  * 2. **Register with population manager**: PushIndividual(), IncLiveArraySize()
  * 3. **Associate with nest** (stage-specific):
- *    - Egg: nest->AddEgg() (new cell created)
- *    - Larva/Prepupa/Pupa/InCocoon: nest->ReplaceNestPointer() (same cell, new occupant)
+ *    - Egg: nest->AddEgg() (new cell created, slot stored in the egg)
+ *    - Larva/Prepupa/Pupa/InCocoon: nest->TransferCell() (same slot, new occupant)
  *    - Female: No nest association (will find own nest during reproduction)
- * 4. **Apply cell lock**: Thread-safe nest modification via SetCellLock/ReleaseCellLock
  * 
  * @par Stage-Specific Handling
  * 
@@ -1992,15 +2279,10 @@ void Osmia_Population_Manager::Init()
  * - If __OSMIA_PESTICIDE_STORE: Assigns unique ID for tracking
  * 
  * @par Thread Safety
- * All nest modifications protected by cell-level locks:
- * ```cpp
- * data->nest->SetCellLock();
- * // ... modify nest data structure ...
- * data->nest->ReleaseCellLock();
- * ```
- * 
- * Prevents race conditions when multiple individuals in same nest transition
- * simultaneously (unlikely but possible in parallel execution).
+ * AddEgg() and AddCocoon() lock the nest internally, because the provisioning
+ * female shares an open nest with any other thread reading it. Stage transitions
+ * use Osmia_Nest::TransferCell(), which locks only while the nest is open. In a
+ * sealed nest each cell slot is owned by its occupant alone, so no lock is needed.
  * 
  * @par Memory Management
  * Objects allocated with `new`, ownership transferred to population manager.
@@ -2037,55 +2319,69 @@ void Osmia_Population_Manager::CreateObjects(TTypeOfOsmiaLifeStages os_type,
 	if (os_type == TTypeOfOsmiaLifeStages::to_OsmiaEgg) RecordEggProduction(number);
 #endif
 	
+	// Raster counts: the new individual enters its stage and, for a transition, the caller leaves its own
+	if (m_Raster.IsOn() && os_type != TTypeOfOsmiaLifeStages::to_OsmiaFemale) {
+		m_Raster.Add(unsigned(os_type), data->x, data->y, number);
+	}
+	if (m_Raster.IsOn() && a_caller != NULL && os_type != TTypeOfOsmiaLifeStages::to_OsmiaEgg) {
+		m_Raster.Add(unsigned(os_type) - 1, data->x, data->y, -number);
+	}
+	// Eggs take their mother's species and every later stage keeps its own
+	if (a_caller != NULL) data->species = static_cast<Osmia_Base*>(a_caller)->GetSpecies();
+
 	for (int i = 0; i < number; i++) {
 		switch (os_type) {
 		case TTypeOfOsmiaLifeStages::to_OsmiaEgg: {
 			Osmia_Egg* new_Osmia_Egg = new Osmia_Egg(data);
 			PushIndividual(int(os_type), new_Osmia_Egg);
 			IncLiveArraySize(int(os_type));
-			data->nest->SetCellLock();
-			data->nest->AddEgg(new_Osmia_Egg);
-			data->nest->ReleaseCellLock();
+			new_Osmia_Egg->SetNestSlot(data->nest->AddEgg(new_Osmia_Egg));  // Locks internally
+#ifdef __OSMIA_LINEAGE
+			if (m_Lineage.IsOpen()) {
+				// The mother is the laying female; struct_Osmia does not carry her identifier
+				uint64_t mother = (a_caller != NULL) ? static_cast<Osmia_Base*>(a_caller)->GetLineageID() : 0;
+				new_Osmia_Egg->SetLineageID(m_Lineage.NewID());
+				RecordLineage(new_Osmia_Egg, data, mother);
+			}
+#endif
 			break;
 		}
 		case TTypeOfOsmiaLifeStages::to_OsmiaLarva: {
 			Osmia_Larva* new_Osmia_Larva = new Osmia_Larva(data);
 			PushIndividual(int(os_type), new_Osmia_Larva);
 			IncLiveArraySize(int(os_type));
-			data->nest->SetCellLock();
-			data->nest->ReplaceNestPointer(a_caller, new_Osmia_Larva);
-			data->nest->ReleaseCellLock();
+			data->nest->TransferCell(data->nestslot, new_Osmia_Larva);
 			break;
 		}
 		case TTypeOfOsmiaLifeStages::to_OsmiaPrepupa: {
 			Osmia_Prepupa* new_Osmia_Prepupa = new Osmia_Prepupa(data);
 			PushIndividual(int(os_type), new_Osmia_Prepupa);
 			IncLiveArraySize(int(os_type));
-			data->nest->SetCellLock();
-			data->nest->ReplaceNestPointer(a_caller, new_Osmia_Prepupa);
-			data->nest->ReleaseCellLock();
+			data->nest->TransferCell(data->nestslot, new_Osmia_Prepupa);
 			break;
 		}
 		case TTypeOfOsmiaLifeStages::to_OsmiaPupa: {
 			Osmia_Pupa* new_Osmia_Pupa = new Osmia_Pupa(data);
 			PushIndividual(int(os_type), new_Osmia_Pupa);
 			IncLiveArraySize(int(os_type));
-			data->nest->SetCellLock();
-			data->nest->ReplaceNestPointer(a_caller, new_Osmia_Pupa);
-			data->nest->ReleaseCellLock();
+			data->nest->TransferCell(data->nestslot, new_Osmia_Pupa);
 			break;
 		}
 		case TTypeOfOsmiaLifeStages::to_OsmiaInCocoon: {
 			Osmia_InCocoon* new_Osmia_InCocoon = new Osmia_InCocoon(data);
 			PushIndividual(int(os_type), new_Osmia_InCocoon);
 			IncLiveArraySize(int(os_type));
-			data->nest->SetCellLock();
 			if (a_caller == NULL) {
-				data->nest->AddCocoon(new_Osmia_InCocoon);  // Initialization
+				new_Osmia_InCocoon->SetNestSlot(data->nest->AddCocoon(new_Osmia_InCocoon));  // Initialization
+#ifdef __OSMIA_LINEAGE
+				if (m_Lineage.IsOpen()) {
+					new_Osmia_InCocoon->SetLineageID(m_Lineage.NewID());
+					RecordLineage(new_Osmia_InCocoon, data, 0);  // Founder, mother unknown
+				}
+#endif
 			} else {
-				data->nest->ReplaceNestPointer(a_caller, new_Osmia_InCocoon);  // Transition
+				data->nest->TransferCell(data->nestslot, new_Osmia_InCocoon);  // Transition
 			}
-			data->nest->ReleaseCellLock();
 			break;
 		}
 		case TTypeOfOsmiaLifeStages::to_OsmiaFemale: {
@@ -2100,6 +2396,10 @@ void Osmia_Population_Manager::CreateObjects(TTypeOfOsmiaLifeStages os_type,
 #endif
 			PushIndividual(int(os_type), new_Osmia_Female);
 			IncLiveArraySize(int(os_type));
+#ifdef __OSMIATESTING
+			m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_EmergenceDay, m_TheLandscape->SupplyDayInYear());
+			m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_FemaleMass, data->mass);
+#endif
 			break;
 		}
 		}
@@ -2160,13 +2460,28 @@ void Osmia_Population_Manager::CreateObjects(TTypeOfOsmiaLifeStages os_type,
  * **5. Prepupal Development Rate**
  * ```cpp
  * temp_i = round(temp)         // Nearest integer temperature
- * if (temp_i < 0) temp_i = 0   // Floor at 0°C
  * m_PrePupalDevelDaysToday = m_PrePupalDevelRates[temp_i]
  * ```
  * 
- * Lookup table indexed by rounded temperature (0-41°C range).
+ * Lookup table indexed by rounded temperature (0-41°C range); the table clamps out-of-range
+ * temperatures to its ends.
  * All prepupae access this shared rate during Step().
  * 
+ * **Daily Environment Snapshot**
+ * Temperature, date, flying hours, the prepupal rate and the pre-wintering and
+ * over-wintering flags are copied into an OsmiaDailyEnvironment and published with
+ * Osmia_Base::SetEnvironment(). The stage development kernels receive it by const
+ * reference, so no agent queries the Landscape or the manager for global state.
+ * The snapshot also holds a nest temperature and a development increment per stage
+ * for each microclimate class (OSMIA_MICROCLIMATE_CLASSES), which brood index by their
+ * nest's class.
+ * 
+ * **6. Parasitoid Host Activity**
+ * Hosts are treated as active from the end of overwintering, or whenever adult
+ * females are alive. Outside that window the parasitoid manager accumulates days and
+ * advances its grid analytically when hosts return (see
+ * OsmiaParasitoid_Population_Manager::Synchronise()).
+ * 
  * @par Execution Order
  * ALMaSS framework ensures DoFirst() called before any individual BeginStep():
  * 1. Population_Manager::DoFirst() (base class)
@@ -2184,8 +2499,27 @@ void Osmia_Population_Manager::CreateObjects(TTypeOfOsmiaLifeStages os_type,
  * individual processing.
  */
 void Osmia_Population_Manager::DoFirst() {
+#ifdef __OSMIA_METRICS
+	m_Metrics.StartPhase(OsmiaMetricsExporter::omph_DoFirst);
+#endif
+	// Grow stage lists ahead of the seasonal peaks (serial, before any agent runs)
+	ReserveStageCapacity();
+
 	// Update daily temperature (shared across all individuals)
-	double temp = m_TheLandscape->SupplyTemp();
+	double temp;
+	if (m_Climate.IsOpen()) {
+		long day = g_date->OldDays() + g_date->DayInYear();
+		if (!m_Climate.HasDay(day)) {
+			m_TheLandscape->Warn("Osmia_Population_Manager::DoFirst()", "climate stream " + cfg_OsmiaClimateStreamFile.value() + " has no record for day " + to_string(day));
+			std::exit(TOP_Osmia);
+		}
+		if (!m_Climate.Advance(day)) {
+			m_TheLandscape->Warn("Osmia_Population_Manager::DoFirst()", "cannot read climate stream");
+			std::exit(TOP_Osmia);
+		}
+		temp = m_Climate.GetTemp();
+	}
+	else temp = m_TheLandscape->SupplyTemp();
 	Osmia_Base::SetTemp(temp);
 	
 	// Calculate foraging hours from weather conditions
@@ -2199,9 +2533,82 @@ void Osmia_Population_Manager::DoFirst() {
 	
 	// Update prepupal development rate
 	int temp_i = int(floor(temp + 0.5));  // Round to nearest integer
-	if (temp_i < 0) temp_i = 0;
-	if (temp_i > 41) temp_i = 41;  // Upper bound check (implicit in array size)
-	m_PrePupalDevelDaysToday = m_PrePupalDevelRates[temp_i];
+	m_PrePupalDevelDaysToday = m_PrePupalDevelRates[temp_i];  // Clamped to 0-41 by the table
+
+	// Publish today's environment snapshot; agents read nothing else global during the step
+	OsmiaDailyEnvironment env;
+	env.m_Temp = temp;
+	env.m_TempInt = temp_i;
+	env.m_DayInYear = m_TheLandscape->SupplyDayInYear();
+	env.m_Month = m_TheLandscape->SupplyMonth();
+	env.m_FlyingHours = m_FlyingWeather;
+	env.m_PrePupalDevelDays = m_PrePupalDevelDaysToday;
+	env.m_PreWinteringEnded = m_PreWinteringEndFlag;
+	env.m_OverWinterEnded = m_OverWinterEndFlag;
+	// One temperature and one development increment per stage for each nest microclimate class
+	bool microclimate = cfg_OsmiaMicroclimate.value();
+	env.m_Microclimate = microclimate;
+	for (int c = 0; c < OSMIA_MICROCLIMATE_CLASSES; c++) {
+		env.m_ClassTemp[c] = microclimate ? temp + cfg_OsmiaMicroclimateOffsets.value(c) : temp;
+		env.m_ClassPrePupaDays[c] = m_PrePupalDevelRates[int(floor(env.m_ClassTemp[c] + 0.5))];
+	}
+	Osmia_Base::SetDevelopmentIncrements(env);
+	Osmia_Base::SetEnvironment(env);
+
+	// Tell the parasitoid grid whether hosts are about (controls macro-stepping)
+	if (m_OurParasitoidPopulationManager != NULL) {
+		bool hosts_active = m_OverWinterEndFlag || (SupplyListSize(int(TTypeOfOsmiaLifeStages::to_OsmiaFemale)) > 0);
+		m_OurParasitoidPopulationManager->SetHostsActive(hosts_active);
+	}
+#ifdef __OSMIA_METRICS
+	m_Metrics.EndPhase(OsmiaMetricsExporter::omph_DoFirst);
+	m_Metrics.StartPhase(OsmiaMetricsExporter::omph_Agents);
+#endif
+}
+
+/**
+ * @brief Reserve stage list capacity ahead of seasonal growth
+ * 
+ * @details Stage lists swing from near zero to very large numbers within days (egg laying in
+ * spring, emergence in summer). Growing a list by push_back during the step means repeated
+ * reallocation and copying of the whole list, inside the parallel region. Instead, each
+ * morning:
+ * 1. Today's count of each stage is stored in m_StageCountHistory, overwriting last year's
+ *    value for this day.
+ * 2. The prediction for each stage is the largest count recorded for the next
+ *    OSMIA_RESERVE_LOOKAHEAD days last year (still last year's values, not yet overwritten).
+ * 3. For eggs, the prediction is raised to the current egg count plus the eggs the live
+ *    females can lay in that window. A female lays at most one egg per day, so each
+ *    contributes min(m_EggsToLay, lookahead). This covers the first year, which has no history.
+ * 4. Any list whose capacity is below prediction × OSMIA_RESERVE_HEADROOM is reserved to that size.
+ * 
+ * Capacity is never released, so each list reallocates at most a few times per run rather
+ * than on every doubling during the peak.
+ */
+void Osmia_Population_Manager::ReserveStageCapacity() {
+	int lookahead = cfg_OsmiaReserveLookahead.value();
+	if (lookahead <= 0) return;
+	int today = m_TheLandscape->SupplyDayInYear();
+	double headroom = cfg_OsmiaReserveHeadroom.value();
+	for (int st = 0; st <= int(TTypeOfOsmiaLifeStages::to_OsmiaFemale); st++) {
+		unsigned count = SupplyListSize(st);
+		m_StageCountHistory[st][today] = count;
+		unsigned predicted = count;
+		for (int d = 1; d <= lookahead; d++) {
+			predicted = max(predicted, m_StageCountHistory[st][(today + d) % 365]);
+		}
+		if (st == int(TTypeOfOsmiaLifeStages::to_OsmiaEgg)) {
+			unsigned eggload = count;
+			int females = SupplyListSize(int(TTypeOfOsmiaLifeStages::to_OsmiaFemale));
+			for (int f = 0; f < females; f++) {
+				Osmia_Female* female = static_cast<Osmia_Female*>(SupplyAnimalPtr(int(TTypeOfOsmiaLifeStages::to_OsmiaFemale), f));
+				if (female->GetCurrentStateNo() != -1) eggload += unsigned(max(0, min(female->GetEggsToLay(), lookahead)));
+			}
+			predicted = max(predicted, eggload);
+		}
+		size_t target = size_t(predicted * headroom);
+		if (target > TheArray[st].capacity()) TheArray[st].reserve(target);
+	}
 }
 
 /**
@@ -2218,6 +2625,359 @@ void Osmia_Population_Manager::TheAOROutputProbe() {
 	m_AOR_Probe->DoProbe(int(TTypeOfOsmiaLifeStages::to_OsmiaFemale));
 }
 
+//==============================================================================
+// SPATIAL OUTPUT RASTERS
+//==============================================================================
+
+void OsmiaRasterOutput::Init(int a_landscapewidth, int a_landscapeheight, int a_cellsize) {
+	m_CellSize = max(a_cellsize, 0);
+	if (m_CellSize == 0) return;
+	m_Width = (a_landscapewidth + m_CellSize - 1) / m_CellSize;
+	m_Height = (a_landscapeheight + m_CellSize - 1) / m_CellSize;
+	for (unsigned l = 0; l < orl_foobar; l++) m_Layers[l].assign(size_t(m_Width) * m_Height, 0);
+}
+
+void OsmiaRasterOutput::EncodeTile(unsigned a_layer, int a_tx, int a_ty, vector<uint8_t>& a_bytes) const {
+	const vector<int>& layer = m_Layers[a_layer];
+	int x0 = a_tx * m_TileSize, y0 = a_ty * m_TileSize;
+	int x1 = min(x0 + m_TileSize, m_Width), y1 = min(y0 + m_TileSize, m_Height);
+	uint64_t run = 0;
+	int value = layer[x0 + size_t(y0) * m_Width];
+	for (int y = y0; y < y1; y++) {
+		for (int x = x0; x < x1; x++) {
+			int v = layer[x + size_t(y) * m_Width];
+			if (v == value) { run++; continue; }
+			OsmiaPutVarint(a_bytes, run);
+			OsmiaPutVarint(a_bytes, OsmiaZigZag(value));
+			value = v;
+			run = 1;
+		}
+	}
+	OsmiaPutVarint(a_bytes, run);
+	OsmiaPutVarint(a_bytes, OsmiaZigZag(value));
+}
+
+bool OsmiaRasterOutput::Write(const string& a_filename, unsigned a_day) const {
+	int tx = (m_Width + m_TileSize - 1) / m_TileSize;
+	int ty = (m_Height + m_TileSize - 1) / m_TileSize;
+	FileHeader header;
+	header.m_magic = m_Magic;
+	header.m_version = 2;
+	header.m_day = a_day;
+	header.m_width = uint32_t(m_Width);
+	header.m_height = uint32_t(m_Height);
+	header.m_cellsize = uint32_t(m_CellSize);
+	header.m_tilesize = uint32_t(m_TileSize);
+	header.m_layers = orl_foobar;
+	header.m_reserved = 0;
+	// Offsets (from the start of the tile data) of each tile, plus one end offset per layer
+	vector<uint64_t> offsets;
+	vector<uint8_t> tiles;
+	for (unsigned l = 0; l < orl_foobar; l++) {
+		for (int j = 0; j < ty; j++) {
+			for (int i = 0; i < tx; i++) {
+				offsets.push_back(tiles.size());
+				EncodeTile(l, i, j, tiles);
+			}
+		}
+	}
+	offsets.push_back(tiles.size());
+	return OsmiaWriteFileAtomically(a_filename, [&](ostream& a_out) {
+		a_out.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+		a_out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+		a_out.write(reinterpret_cast<const char*>(tiles.data()), tiles.size());
+	});
+}
+
+/**
+ * @details Called at the end of DoLast(). The female layer takes the density of the 1 km
+ * density grid cell containing each raster cell centre, and the parasitoid layer the summed
+ * parasitoid numbers at the cell centre per km2. Both are densities, not counts, so sparse
+ * populations do not round away (see OsmiaRasterOutput).
+ */
+void Osmia_Population_Manager::WriteRasters() {
+	unsigned day = g_date->OldDays() + g_date->DayInYear();
+	int interval = cfg_OsmiaRasterInterval.value();
+	if (day % unsigned(interval) != 0) return;
+	int cs = m_Raster.GetCellSize();
+	double paradensity = 0.0;  // Parasitoid cell count to parasitoids per km2
+	if (m_OurParasitoidPopulationManager != NULL) {
+		double pcs = double(m_OurParasitoidPopulationManager->GetCellSize());
+		paradensity = 1.0e6 / (pcs * pcs);
+	}
+	int gridheight = (m_GridExtent > 0) ? int(m_FemaleDensityGrid.size()) / m_GridExtent : 0;
+	for (int cy = 0; cy < m_Raster.GetHeight(); cy++) {
+		for (int cx = 0; cx < m_Raster.GetWidth(); cx++) {
+			int x = min(cx * cs + cs / 2, SimW - 1);
+			int y = min(cy * cs + cs / 2, SimH - 1);
+			int gx = x / 1000, gy = y / 1000;
+			int females = (gx < m_GridExtent && gy < gridheight) ? m_FemaleDensityGrid[gx + gy * m_GridExtent] : 0;
+			m_Raster.SetCell(OsmiaRasterOutput::orl_Female, cx, cy, females);  // 1 km cells, so already per km2
+			double paras = 0.0;
+			if (m_OurParasitoidPopulationManager != NULL) {
+				auto numbers = m_OurParasitoidPopulationManager->GetParasitoidNumbers(x, y);
+				for (double n : numbers) paras += n;
+			}
+			m_Raster.SetCell(OsmiaRasterOutput::orl_Parasitoid, cx, cy, int(floor(paras * paradensity + 0.5)));
+		}
+	}
+	string prefix = cfg_OsmiaRasterPrefix.value();
+	if (!m_Raster.Write(prefix + "_" + to_string(day) + ".orst", day)) {
+		m_TheLandscape->Warn("Osmia_Population_Manager::WriteRasters()", "cannot write raster snapshot");
+	}
+}
+
+#ifdef __OSMIA_LINEAGE
+//==============================================================================
+// LINEAGE RECORDING (Conditional compilation)
+//==============================================================================
+
+void Osmia_Population_Manager::RecordLineage(Osmia_Base* a_new, struct_Osmia* a_data, uint64_t a_mother) {
+#ifdef __OSMIATESTING
+	// Every egg is laid by a female that was herself logged, as an egg or as a founder
+	if (a_new->GetStage() == TTypeOfOsmiaLifeStages::to_OsmiaEgg && (a_mother == 0 || a_mother >= a_new->GetLineageID())) {
+		m_TheLandscape->Warn("Osmia_Population_Manager::RecordLineage()", "egg lineage record does not point back to a logged mother");
+		std::exit(TOP_Osmia);
+	}
+#endif
+	OsmiaLineageLog::Record rec;
+	rec.m_id = a_new->GetLineageID();
+	rec.m_mother = a_mother;
+	rec.m_day = g_date->OldDays() + g_date->DayInYear();
+	rec.m_x = a_data->nest->GetX();
+	rec.m_y = a_data->nest->GetY();
+	rec.m_polyref = a_data->nest->GetPolyRef();
+	rec.m_nestslot = a_new->GetNestSlot();
+	rec.m_mass = a_data->mass;
+	rec.m_sex = a_data->sex;
+	rec.m_parasitised = unsigned(a_data->parasitised);
+	m_Lineage.Append(rec);
+}
+
+bool OsmiaLineageLog::Open(const string& a_filename, int a_threads) {
+	m_File.open(a_filename, ios::out | ios::binary | ios::trunc);
+	if (!m_File.is_open()) return false;
+	FileHeader header;
+	header.m_magic = m_FileMagic;
+	header.m_version = 1;
+	header.m_reserved = 0;
+	m_File.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+	m_Segments.assign(max(a_threads, 1), Segment());
+	m_Index.clear();
+	m_Open = true;
+	return true;
+}
+
+void OsmiaLineageLog::Append(const Record& a_record) {
+	unsigned thread = unsigned(omp_get_thread_num());
+	Segment& seg = m_Segments[thread < m_Segments.size() ? thread : 0];
+	if (seg.m_count == 0) {
+		seg.m_firstid = a_record.m_id;
+		seg.m_lastid = 0;
+		seg.m_day = a_record.m_day;
+	}
+	// Identifiers are issued in increasing order, so within one thread the delta is positive
+	OsmiaPutVarint(seg.m_bytes, a_record.m_id - seg.m_lastid);
+	OsmiaPutVarint(seg.m_bytes, (a_record.m_mother == 0) ? 0 : a_record.m_id - a_record.m_mother);
+	OsmiaPutVarint(seg.m_bytes, uint64_t(a_record.m_x));
+	OsmiaPutVarint(seg.m_bytes, uint64_t(a_record.m_y));
+	OsmiaPutVarint(seg.m_bytes, uint64_t(a_record.m_polyref));
+	OsmiaPutVarint(seg.m_bytes, uint64_t(a_record.m_nestslot + 1));
+	OsmiaPutVarint(seg.m_bytes, uint64_t(floor(a_record.m_mass * 100.0 + 0.5)));
+	OsmiaPutVarint(seg.m_bytes, (a_record.m_sex ? 1u : 0u) | (a_record.m_parasitised << 1));
+	seg.m_lastid = a_record.m_id;
+	seg.m_count++;
+}
+
+void OsmiaLineageLog::Flush() {
+	for (unsigned t = 0; t < m_Segments.size(); t++) {
+		Segment& seg = m_Segments[t];
+		if (seg.m_count == 0) continue;
+		IndexEntry entry;
+		entry.m_offset = uint64_t(m_File.tellp());
+		entry.m_firstid = seg.m_firstid;
+		entry.m_lastid = seg.m_lastid;
+		entry.m_day = seg.m_day;
+		entry.m_count = seg.m_count;
+		BlockHeader block;
+		block.m_day = seg.m_day;
+		block.m_thread = t;
+		block.m_count = seg.m_count;
+		block.m_bytes = uint32_t(seg.m_bytes.size());
+		m_File.write(reinterpret_cast<const char*>(&block), sizeof(BlockHeader));
+		m_File.write(reinterpret_cast<const char*>(seg.m_bytes.data()), seg.m_bytes.size());
+		m_Index.push_back(entry);
+		seg.m_bytes.clear();  // Keeps capacity for the next day
+		seg.m_count = 0;
+	}
+}
+
+void OsmiaLineageLog::Close() {
+	Flush();
+	Trailer trailer;
+	trailer.m_indexoffset = uint64_t(m_File.tellp());
+	trailer.m_entries = m_Index.size();
+	trailer.m_magic = m_IndexMagic;
+	m_File.write(reinterpret_cast<const char*>(m_Index.data()), m_Index.size() * sizeof(IndexEntry));
+	m_File.write(reinterpret_cast<const char*>(&trailer), sizeof(Trailer));
+	m_File.close();
+	m_Open = false;
+}
+
+bool OsmiaLineageReader::Open(const string& a_filename) {
+	m_File.open(a_filename, ios::in | ios::binary);
+	if (!m_File.is_open()) return false;
+	OsmiaLineageLog::FileHeader header;
+	if (!m_File.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.m_magic != OsmiaLineageLog::m_FileMagic) return false;
+	OsmiaLineageLog::Trailer trailer;
+	m_File.seekg(-streamoff(sizeof(trailer)), ios::end);
+	if (!m_File.read(reinterpret_cast<char*>(&trailer), sizeof(trailer)) || trailer.m_magic != OsmiaLineageLog::m_IndexMagic) return false;
+	m_Index.resize(size_t(trailer.m_entries));
+	m_File.seekg(streamoff(trailer.m_indexoffset), ios::beg);
+	return bool(m_File.read(reinterpret_cast<char*>(m_Index.data()), m_Index.size() * sizeof(OsmiaLineageLog::IndexEntry)));
+}
+
+bool OsmiaLineageReader::ReadBlock(size_t a_block, vector<OsmiaLineageLog::Record>& a_records) {
+	if (a_block >= m_Index.size()) return false;
+	OsmiaLineageLog::BlockHeader block;
+	m_File.clear();
+	m_File.seekg(streamoff(m_Index[a_block].m_offset), ios::beg);
+	if (!m_File.read(reinterpret_cast<char*>(&block), sizeof(block))) return false;
+	vector<uint8_t> bytes(block.m_bytes);
+	if (!m_File.read(reinterpret_cast<char*>(bytes.data()), bytes.size())) return false;
+	const uint8_t* pos = bytes.data();
+	const uint8_t* end = pos + bytes.size();
+	uint64_t lastid = 0;
+	for (uint32_t r = 0; r < block.m_count; r++) {
+		uint64_t v[8];
+		for (int f = 0; f < 8; f++) {
+			if (!OsmiaGetVarint(pos, end, v[f])) return false;
+		}
+		OsmiaLineageLog::Record rec;
+		rec.m_id = lastid + v[0];
+		rec.m_mother = (v[1] == 0) ? 0 : rec.m_id - v[1];
+		rec.m_day = block.m_day;
+		rec.m_x = int(v[2]);
+		rec.m_y = int(v[3]);
+		rec.m_polyref = int(v[4]);
+		rec.m_nestslot = int(v[5]) - 1;
+		rec.m_mass = double(v[6]) / 100.0;
+		rec.m_sex = (v[7] & 1) != 0;
+		rec.m_parasitised = unsigned(v[7] >> 1);
+		lastid = rec.m_id;
+		a_records.push_back(rec);
+	}
+	return true;
+}
+
+bool OsmiaLineageReader::ReadDays(unsigned a_firstday, unsigned a_lastday, vector<OsmiaLineageLog::Record>& a_records) {
+	for (size_t b = 0; b < m_Index.size(); b++) {
+		if (m_Index[b].m_day < a_firstday || m_Index[b].m_day > a_lastday) continue;
+		if (!ReadBlock(b, a_records)) return false;
+	}
+	return true;
+}
+
+bool OsmiaLineageReader::FindIndividual(uint64_t a_id, OsmiaLineageLog::Record& a_record) {
+	vector<OsmiaLineageLog::Record> records;
+	for (size_t b = 0; b < m_Index.size(); b++) {
+		if (a_id < m_Index[b].m_firstid || a_id > m_Index[b].m_lastid) continue;
+		records.clear();
+		if (!ReadBlock(b, records)) return false;
+		for (const OsmiaLineageLog::Record& rec : records) {
+			if (rec.m_id == a_id) {
+				a_record = rec;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool OsmiaLineageReader::FindOffspring(uint64_t a_mother, vector<OsmiaLineageLog::Record>& a_records) {
+	vector<OsmiaLineageLog::Record> records;
+	for (size_t b = 0; b < m_Index.size(); b++) {
+		if (m_Index[b].m_lastid <= a_mother) continue;
+		records.clear();
+		if (!ReadBlock(b, records)) return false;
+		for (const OsmiaLineageLog::Record& rec : records) {
+			if (rec.m_mother == a_mother) a_records.push_back(rec);
+		}
+	}
+	return true;
+}
+#endif // __OSMIA_LINEAGE
+
+#ifdef __OSMIA_METRICS
+//==============================================================================
+// LIVE METRICS EXPORT (Conditional compilation)
+//==============================================================================
+
+/**
+ * @details Memory is estimated as list capacity times pointer size plus live count times
+ * object size. Heap storage owned by individuals (e.g. female nest plans) is not included,
+ * so the value is a lower bound, but it follows the seasonal swings that matter.
+ */
+void Osmia_Population_Manager::PublishMetrics() {
+	long day = g_date->OldDays() + g_date->DayInYear();
+	if (!m_Metrics.IsDue(day)) return;
+	static const size_t objectsize[6] = { sizeof(Osmia_Egg), sizeof(Osmia_Larva), sizeof(Osmia_Prepupa),
+		sizeof(Osmia_Pupa), sizeof(Osmia_InCocoon), sizeof(Osmia_Female) };
+	vector<OsmiaMetricsExporter::StageSnapshot> stages(6);
+	for (int st = 0; st < 6; st++) {
+		stages[st].m_name = m_ListNames[st].c_str();
+		stages[st].m_count = SupplyListSize(st);
+		stages[st].m_bytes = double(TheArray[st].capacity()) * sizeof(TAnimal*) + double(stages[st].m_count) * objectsize[st];
+	}
+	m_Metrics.Write(day, g_date->GetYear(), stages, Osmia_Nest::m_LockWaitSeconds, Osmia_Nest::m_LockedTransfers);
+}
+
+void OsmiaMetricsExporter::Write(long a_day, int a_year, const vector<StageSnapshot>& a_stages, double a_lockwaitsecs, unsigned long a_lockedtransfers) const {
+	static const char* phasenames[omph_foobar] = { "dofirst", "agents", "dolast" };
+	OsmiaWriteFileAtomically(m_Filename, [&](ostream& ofile) {
+		ofile.precision(10);
+		ofile << "# HELP osmia_simulated_day Simulated day number since the start of the run" << endl;
+		ofile << "# TYPE osmia_simulated_day gauge" << endl;
+		ofile << "osmia_simulated_day " << a_day << endl;
+		ofile << "# HELP osmia_simulated_year Simulated year" << endl;
+		ofile << "# TYPE osmia_simulated_year gauge" << endl;
+		ofile << "osmia_simulated_year " << a_year << endl;
+		ofile << "# HELP osmia_stage_individuals Live individuals per life stage" << endl;
+		ofile << "# TYPE osmia_stage_individuals gauge" << endl;
+		unsigned total = 0;
+		for (const StageSnapshot& st : a_stages) {
+			ofile << "osmia_stage_individuals{stage=\"" << st.m_name << "\"} " << st.m_count << endl;
+			total += st.m_count;
+		}
+		ofile << "# HELP osmia_stage_memory_bytes Estimated memory per life stage (lower bound)" << endl;
+		ofile << "# TYPE osmia_stage_memory_bytes gauge" << endl;
+		for (const StageSnapshot& st : a_stages) {
+			ofile << "osmia_stage_memory_bytes{stage=\"" << st.m_name << "\"} " << st.m_bytes << endl;
+		}
+		ofile << "# HELP osmia_phase_seconds Wall-clock time of each daily phase on the last simulated day" << endl;
+		ofile << "# TYPE osmia_phase_seconds gauge" << endl;
+		for (unsigned ph = 0; ph < omph_foobar; ph++) {
+			ofile << "osmia_phase_seconds{phase=\"" << phasenames[ph] << "\"} " << m_PhaseSeconds[ph] << endl;
+		}
+		ofile << "# HELP osmia_phase_seconds_total Cumulative wall-clock time of each daily phase" << endl;
+		ofile << "# TYPE osmia_phase_seconds_total counter" << endl;
+		for (unsigned ph = 0; ph < omph_foobar; ph++) {
+			ofile << "osmia_phase_seconds_total{phase=\"" << phasenames[ph] << "\"} " << m_PhaseTotalSeconds[ph] << endl;
+		}
+		double agentsecs = m_PhaseSeconds[omph_Agents];
+		ofile << "# HELP osmia_agents_per_second Live individuals stepped per second on the last simulated day" << endl;
+		ofile << "# TYPE osmia_agents_per_second gauge" << endl;
+		ofile << "osmia_agents_per_second " << ((agentsecs > 0.0) ? total / agentsecs : 0.0) << endl;
+		ofile << "# HELP osmia_nest_lock_wait_seconds_total Time threads have spent waiting for contended nest locks" << endl;
+		ofile << "# TYPE osmia_nest_lock_wait_seconds_total counter" << endl;
+		ofile << "osmia_nest_lock_wait_seconds_total " << a_lockwaitsecs << endl;
+		ofile << "# HELP osmia_nest_locked_transfers_total Brood transitions in nests still open, which take the nest lock" << endl;
+		ofile << "# TYPE osmia_nest_locked_transfers_total counter" << endl;
+		ofile << "osmia_nest_locked_transfers_total " << a_lockedtransfers << endl;
+	}, false);
+}
+#endif // __OSMIA_METRICS
+
 //==============================================================================
 // TESTING/VALIDATION METHODS (Conditional compilation)
 //==============================================================================
@@ -2242,6 +3002,7 @@ void Osmia_Population_Manager::RecordEggProduction(int a_eggs) {
  */
 void Osmia_Population_Manager::RecordEggLength(int a_length) {
 	m_EggStageLength.add_variable(a_length);
+	m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_EggStageLength, a_length);
 }
 
 /**
@@ -2250,6 +3011,7 @@ void Osmia_Population_Manager::RecordEggLength(int a_length) {
  */
 void Osmia_Population_Manager::RecordLarvalLength(int a_length) {
 	m_LarvalStageLength.add_variable(a_length);
+	m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_LarvalStageLength, a_length);
 }
 
 /**
@@ -2258,6 +3020,7 @@ void Osmia_Population_Manager::RecordLarvalLength(int a_length) {
  */
 void Osmia_Population_Manager::RecordPrePupaLength(int a_length) {
 	m_PrePupaStageLength.add_variable(a_length);
+	m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_PrePupalStageLength, a_length);
 }
 
 /**
@@ -2266,6 +3029,7 @@ void Osmia_Population_Manager::RecordPrePupaLength(int a_length) {
  */
 void Osmia_Population_Manager::RecordPupaLength(int a_length) {
 	m_PupaStageLength.add_variable(a_length);
+	m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_PupalStageLength, a_length);
 }
 
 /**
@@ -2281,6 +3045,188 @@ void Osmia_Population_Manager::RecordPupaLength(int a_length) {
  */
 void Osmia_Population_Manager::RecordInCocoonLength(int a_length) {
 	m_InCocoonStageLength.add_variable(a_length);
+	m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_InCocoonStageLength, a_length);
+}
+
+//==============================================================================
+// STATISTICAL EQUIVALENCE HARNESS
+//==============================================================================
+
+const char* OsmiaEquivalenceHarness::MetricName(unsigned a_metric)
+{
+	static const char* names[oem_foobar] = {
+		"EggStageLength", "LarvalStageLength", "PrePupalStageLength", "PupalStageLength",
+		"InCocoonStageLength", "EmergenceDay", "FemaleMass", "YearlyNests", "YearlyPopulation"
+	};
+	return (a_metric < oem_foobar) ? names[a_metric] : "Unknown";
+}
+
+/**
+ * @details File format (text): a header line `OSMIA_EQUIVALENCE 1 <engine>`, then for each
+ * metric a line `<name> <count>` followed by the samples on one line.
+ */
+void OsmiaEquivalenceHarness::Write(const string& a_filename, const string& a_engine) const
+{
+	ofstream ofile(a_filename, ios::out);
+	ofile.precision(17);
+	ofile << "OSMIA_EQUIVALENCE 1 " << a_engine << endl;
+	for (unsigned m = 0; m < oem_foobar; m++) {
+		ofile << MetricName(m) << ' ' << m_Samples[m].size() << endl;
+		for (double v : m_Samples[m]) ofile << v << ' ';
+		ofile << endl;
+	}
+	ofile.close();
+}
+
+bool OsmiaEquivalenceHarness::Read(const string& a_filenames)
+{
+	istringstream names(a_filenames);
+	string filename;
+	bool any = false;
+	while (names >> filename) {
+		ifstream ifile(filename, ios::in);
+		string magic, engine;
+		int version;
+		if (!(ifile >> magic >> version >> engine) || magic != "OSMIA_EQUIVALENCE" || version != 1) return false;
+		for (unsigned m = 0; m < oem_foobar; m++) {
+			string name;
+			size_t n;
+			if (!(ifile >> name >> n) || name != MetricName(m)) return false;
+			for (size_t i = 0; i < n; i++) {
+				double v;
+				if (!(ifile >> v)) return false;
+				m_Samples[m].push_back(v);
+			}
+		}
+		any = true;
+	}
+	return any;
+}
+
+double OsmiaEquivalenceHarness::KolmogorovSmirnov(const vector<double>& a_x, const vector<double>& a_y, double& a_D)
+{
+	size_t n = a_x.size(), m = a_y.size();
+	size_t i = 0, j = 0;
+	a_D = 0.0;
+	while (i < n && j < m) {
+		// Step past all copies of the next value in both samples, so ties are handled correctly
+		double v = min(a_x[i], a_y[j]);
+		while (i < n && a_x[i] == v) i++;
+		while (j < m && a_y[j] == v) j++;
+		a_D = max(a_D, fabs(double(i) / n - double(j) / m));
+	}
+	double ne = double(n) * m / double(n + m);
+	double lambda = (sqrt(ne) + 0.12 + 0.11 / sqrt(ne)) * a_D;
+	// Kolmogorov distribution Q(lambda) = 2 sum (-1)^(k-1) exp(-2 k^2 lambda^2)
+	double sum = 0.0, sign = 1.0;
+	for (int k = 1; k <= 100; k++) {
+		double term = sign * 2.0 * exp(-2.0 * k * k * lambda * lambda);
+		sum += term;
+		if (fabs(term) < 1e-10 * fabs(sum)) return min(1.0, max(0.0, sum));
+		sign = -sign;
+	}
+	return 1.0;  // Series did not converge: lambda very small, p close to 1
+}
+
+/**
+ * @details Implements A2akN of Scholz and Stephens (1987), the version for data with ties,
+ * and standardises it with the exact finite-sample variance for k = 2 samples.
+ */
+double OsmiaEquivalenceHarness::AndersonDarling(const vector<double>& a_x, const vector<double>& a_y)
+{
+	const vector<double>* samples[2] = { &a_x, &a_y };
+	double nsize[2] = { double(a_x.size()), double(a_y.size()) };
+	double N = nsize[0] + nsize[1];
+	size_t pos[2] = { 0, 0 };
+	double cum[2] = { 0.0, 0.0 };  // Number of each sample <= current value
+	double A2 = 0.0;
+	while (pos[0] < a_x.size() || pos[1] < a_y.size()) {
+		double v = (pos[0] == a_x.size()) ? a_y[pos[1]] : (pos[1] == a_y.size()) ? a_x[pos[0]] : min(a_x[pos[0]], a_y[pos[1]]);
+		double f[2];
+		for (int s = 0; s < 2; s++) {
+			size_t start = pos[s];
+			while (pos[s] < samples[s]->size() && (*samples[s])[pos[s]] == v) pos[s]++;
+			f[s] = double(pos[s] - start);
+			cum[s] += f[s];
+		}
+		double l = f[0] + f[1];
+		double B = cum[0] + cum[1] - l / 2.0;
+		double denom = B * (N - B) - N * l / 4.0;
+		if (denom <= 0.0) continue;
+		for (int s = 0; s < 2; s++) {
+			double M = cum[s] - f[s] / 2.0;
+			A2 += l * (N * M - nsize[s] * B) * (N * M - nsize[s] * B) / (nsize[s] * denom);
+		}
+	}
+	A2 *= (N - 1.0) / (N * N);
+
+	// Variance of A2 under the null (Scholz and Stephens 1987, eq. 4) with k = 2
+	double k = 2.0;
+	double H = 1.0 / nsize[0] + 1.0 / nsize[1];
+	int Ni = int(N);
+	vector<double> harmonic(Ni, 0.0);  // harmonic[i] = sum_{j=1}^{i} 1/j
+	for (int i = 1; i < Ni; i++) harmonic[i] = harmonic[i - 1] + 1.0 / i;
+	double h = harmonic[Ni - 1];
+	double g = 0.0;
+	for (int i = 1; i <= Ni - 2; i++) g += (h - harmonic[i]) / (N - i);
+	double a = (4 * g - 6) * (k - 1) + (10 - 6 * g) * H;
+	double b = (2 * g - 4) * k * k + 8 * h * k + (2 * g - 14 * h - 4) * H - 8 * h + 4 * g - 6;
+	double c = (6 * h + 2 * g - 2) * k * k + (4 * h - 4 * g + 6) * k + (2 * h - 6) * H + 4 * h;
+	double d = (2 * h + 6) * k * k - 4 * h * k;
+	double var = (a * N * N * N + b * N * N + c * N + d) / ((N - 1) * (N - 2) * (N - 3));
+	return (A2 - (k - 1)) / sqrt(var);
+}
+
+double OsmiaEquivalenceHarness::AndersonDarlingCritical(double a_alpha)
+{
+	// Scholz and Stephens (1987) Table 1, m = k - 1 = 1, infinite sample size
+	static const double alphas[5] = { 0.25, 0.10, 0.05, 0.025, 0.01 };
+	static const double crit[5] = { 0.326, 1.225, 1.960, 2.719, 3.752 };
+	if (a_alpha >= alphas[0]) return crit[0];
+	for (int i = 1; i < 5; i++) {
+		if (a_alpha >= alphas[i]) {
+			double t = (log(a_alpha) - log(alphas[i - 1])) / (log(alphas[i]) - log(alphas[i - 1]));
+			return crit[i - 1] + t * (crit[i] - crit[i - 1]);
+		}
+	}
+	// Below the table: extrapolate along the last segment
+	double t = (log(a_alpha) - log(alphas[3])) / (log(alphas[4]) - log(alphas[3]));
+	return crit[3] + t * (crit[4] - crit[3]);
+}
+
+bool OsmiaEquivalenceHarness::Compare(const OsmiaEquivalenceHarness& a_reference, const OsmiaEquivalenceHarness& a_candidate, double a_alpha, ostream& a_report)
+{
+	// Bonferroni correction over the metrics that have enough samples to test
+	int tested = 0;
+	for (unsigned m = 0; m < oem_foobar; m++) {
+		if (a_reference.m_Samples[m].size() >= 2 && a_candidate.m_Samples[m].size() >= 2) tested++;
+	}
+	double alpha = a_alpha / max(tested, 1);
+	double adcrit = AndersonDarlingCritical(alpha);
+	bool allpass = true;
+	a_report << "Metric\tN_ref\tN_cand\tKS_D\tKS_p\tAD_T\tAD_crit\tResult" << endl;
+	for (unsigned m = 0; m < oem_foobar; m++) {
+		vector<double> x = a_reference.m_Samples[m];
+		vector<double> y = a_candidate.m_Samples[m];
+		a_report << MetricName(m) << '\t' << x.size() << '\t' << y.size() << '\t';
+		if (x.size() < 2 || y.size() < 2) {
+			a_report << "-\t-\t-\t-\tSKIPPED (too few samples)" << endl;
+			continue;
+		}
+		sort(x.begin(), x.end());
+		sort(y.begin(), y.end());
+		MetricResult r;
+		r.m_KS_p = KolmogorovSmirnov(x, y, r.m_KS_D);
+		r.m_AD_T = AndersonDarling(x, y);
+		r.m_AD_critical = adcrit;
+		r.m_pass = (r.m_KS_p >= alpha) && (r.m_AD_T < adcrit);
+		allpass = allpass && r.m_pass;
+		a_report << r.m_KS_D << '\t' << r.m_KS_p << '\t' << r.m_AD_T << '\t' << r.m_AD_critical << '\t'
+		         << (r.m_pass ? "PASS" : "FAIL") << endl;
+	}
+	a_report << "Per-metric alpha (Bonferroni): " << alpha << endl;
+	a_report << "OVERALL: " << (allpass ? "PASS" : "FAIL") << endl;
+	return allpass;
 }
 
 #endif // __OSMIATESTING
@@ -2367,6 +3313,775 @@ void Osmia_Population_Manager::RecordInCocoonLength(int a_length) {
 void Osmia_Population_Manager::CalForageHours(void) {
 	// Implementation delegated to landscape/weather system
 	// Actual calculation follows pattern described above
-	m_FlyingWeather = g_weather->GetFlyingHours();
+	if (m_Climate.IsOpen() && m_Climate.HasHours()) m_FlyingWeather = m_Climate.GetFlyingHours();
+	else m_FlyingWeather = g_weather->GetFlyingHours();
+}
+
+
+//==============================================================================
+// STREAMING CLIMATE INPUT
+//==============================================================================
+
+bool OsmiaClimateStream::Open(const string& a_filename, unsigned a_windowdays)
+{
+	Close();
+	FileHeader header;
+#ifdef OSMIA_CLIMATE_MMAP
+	m_Fd = open(a_filename.c_str(), O_RDONLY);
+	if (m_Fd < 0) return false;
+	if (pread(m_Fd, &header, sizeof(FileHeader), 0) != ssize_t(sizeof(FileHeader))) {
+		Close();
+		return false;
+	}
+	struct stat info;
+	uint64_t filesize = (fstat(m_Fd, &info) == 0) ? uint64_t(info.st_size) : 0;
+#else
+	m_File.open(a_filename, ios::in | ios::binary);
+	if (!m_File.is_open() || !m_File.read(reinterpret_cast<char*>(&header), sizeof(FileHeader))) {
+		Close();
+		return false;
+	}
+	m_File.seekg(0, ios::end);
+	uint64_t filesize = uint64_t(m_File.tellg());
+#endif
+	if (header.m_magic != m_Magic || header.m_version != m_Version || header.m_recordsize != sizeof(DayRecord)
+		|| header.m_nodays == 0 || filesize < sizeof(FileHeader) + uint64_t(header.m_nodays) * sizeof(DayRecord)) {
+		Close();
+		return false;
+	}
+	m_Header = header;
+	m_WindowDays = max(a_windowdays, 1u);
+	return true;
+}
+
+void OsmiaClimateStream::Close()
+{
+#ifdef OSMIA_CLIMATE_MMAP
+	if (m_Map != NULL) munmap(m_Map, m_MapLength);
+	m_Map = NULL;
+	m_MapLength = 0;
+	if (m_Fd >= 0) close(m_Fd);
+	m_Fd = -1;
+#else
+	if (m_File.is_open()) m_File.close();
+	m_File.clear();
+	vector<DayRecord>().swap(m_Buffer);
+#endif
+	m_Header = FileHeader();
+	m_Window = NULL;
+	m_WindowFirst = 0;
+	m_WindowCount = 0;
+	m_Started = false;
+}
+
+const OsmiaClimateStream::DayRecord* OsmiaClimateStream::Fetch(long a_day)
+{
+	if (!HasDay(a_day)) return NULL;
+	uint64_t index = uint64_t(a_day);
+	if (m_WindowCount == 0 || index < m_WindowFirst || index >= m_WindowFirst + m_WindowCount) {
+		uint64_t first = index - index % m_WindowDays;
+		uint64_t count = min(uint64_t(m_WindowDays), uint64_t(m_Header.m_nodays) - first);
+		uint64_t start = sizeof(FileHeader) + first * sizeof(DayRecord);
+#ifdef OSMIA_CLIMATE_MMAP
+		if (m_Map != NULL) munmap(m_Map, m_MapLength);
+		m_Map = NULL;
+		uint64_t page = uint64_t(sysconf(_SC_PAGESIZE));
+		uint64_t aligned = start - start % page;
+		m_MapLength = size_t(start - aligned + count * sizeof(DayRecord));
+		void* map = mmap(NULL, m_MapLength, PROT_READ, MAP_PRIVATE, m_Fd, off_t(aligned));
+		if (map == MAP_FAILED) {
+			m_WindowCount = 0;
+			return NULL;
+		}
+		madvise(map, m_MapLength, MADV_SEQUENTIAL);
+		m_Map = static_cast<char*>(map);
+		m_Window = reinterpret_cast<const DayRecord*>(m_Map + (start - aligned));
+#else
+		m_Buffer.resize(size_t(count));
+		m_File.clear();
+		m_File.seekg(std::streamoff(start));
+		if (!m_File.read(reinterpret_cast<char*>(m_Buffer.data()), std::streamsize(count * sizeof(DayRecord)))) {
+			m_WindowCount = 0;
+			return NULL;
+		}
+		m_Window = m_Buffer.data();
+#endif
+		m_WindowFirst = first;
+		m_WindowCount = count;
+	}
+	return m_Window + (index - m_WindowFirst);
+}
+
+bool OsmiaClimateStream::Advance(long a_day)
+{
+	if (!HasDay(a_day)) return false;
+	if (!m_Started || a_day != m_Today + 1) {
+		// Refill the whole history, oldest first; days before the file starts repeat record 0
+		for (long d = a_day - (m_HistoryDays - 1); d < a_day; d++) {
+			const DayRecord* past = Fetch(max(d, 0L));
+			if (past == NULL) return false;
+			m_History[Slot(d)] = past->m_meantemp;
+		}
+	}
+	const DayRecord* rec = Fetch(a_day);
+	if (rec == NULL) return false;
+	m_History[Slot(a_day)] = rec->m_meantemp;
+	int hours = 0;
+	if (HasHours()) {
+		for (int h = 0; h < m_HoursPerDay; h++) {
+			if (rec->m_temp[h] > m_MinFlyingTemp && rec->m_wind[h] < m_MaxFlyingWind && rec->m_rain[h] < m_MaxFlyingRain) hours++;
+		}
+	}
+	m_FlyingHours = hours;
+	m_Today = a_day;
+	m_Started = true;
+	return true;
+}
+
+bool OsmiaClimateStream::Convert(const string& a_textfile, const string& a_binfile, bool a_hourly)
+{
+	ifstream ifile(a_textfile, ios::in);
+	if (!ifile.is_open()) return false;
+	vector<DayRecord> days;
+	vector<int> hourcount;  // Hourly rows seen per day
+	const int columns = a_hourly ? 7 : 6;
+	string line;
+	long lastdate = -1;
+	while (getline(ifile, line)) {
+		double v[7];
+		int n = 0;
+		const char* pos = line.c_str();
+		while (n < columns) {
+			char* end;
+			double value = strtod(pos, &end);
+			if (end == pos) break;
+			v[n++] = value;
+			pos = end;
+		}
+		if (n < columns) continue;
+		long date = long(v[0]) * 10000 + long(v[1]) * 100 + long(v[2]);
+		if (date != lastdate) {
+			days.push_back(DayRecord());
+			hourcount.push_back(0);
+			lastdate = date;
+		}
+		DayRecord& rec = days.back();
+		if (a_hourly) {
+			int h = ((int(v[3]) % m_HoursPerDay) + m_HoursPerDay) % m_HoursPerDay;
+			rec.m_temp[h] = float(v[4]);
+			rec.m_wind[h] = float(v[5]);
+			rec.m_rain[h] = float(v[6]);
+			rec.m_meantemp += float(v[4]);
+			hourcount.back()++;
+		}
+		else rec.m_meantemp = float(v[3]);
+	}
+	if (days.empty()) return false;
+	for (size_t d = 0; d < days.size(); d++) {
+		if (hourcount[d] > 0) days[d].m_meantemp /= float(hourcount[d]);
+	}
+
+	FileHeader header;
+	header.m_magic = m_Magic;
+	header.m_version = m_Version;
+	header.m_nodays = uint32_t(days.size());
+	header.m_recordsize = uint32_t(sizeof(DayRecord));
+	header.m_hourly = a_hourly ? 1 : 0;
+	return OsmiaWriteFileAtomically(a_binfile, [&](ostream& a_out) {
+		a_out.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+		a_out.write(reinterpret_cast<const char*>(days.data()), days.size() * sizeof(DayRecord));
+	});
+}
+
+//==============================================================================
+// PARASITOID MACRO-STEPPING (Host-free periods)
+//==============================================================================
+
+/**
+ * @details The month is set first so that the per-day survival recorded for a skipped
+ * day uses the same mortality rate the daily model would have applied.
+ */
+void OsmiaParasitoid_Population_Manager::DoFirst()
+{
+	if (m_SubPopulations.empty()) return;
+	MergeThreadBuffers();
+	m_SubPopulations[0]->SetThisMonth(m_TheLandscape->SupplyMonth() - 1);
+	m_DayDeferred = cfg_OsmiaParasMacroStep.value() && !m_HostsActive;
+	if (m_DayDeferred) {
+		m_PendingDays++;
+		m_PendingSurvival *= 1.0 - OsmiaParasitoidSubPopulation::GetMortalityThisMonth();
+		return;
+	}
+	Synchronise();
+}
+
+void OsmiaParasitoidSubPopulation::DoFirst()
+{
+	if (m_OurPopulationManager->IsDayDeferred()) return;
+	DailyMortality();
+	Dispersal();
+	if (m_OurPopulationManager->AreHostsActive()) Reproduce();
+}
+
+void OsmiaParasitoid_Population_Manager::SetHostsActive(bool a_active)
+{
+	if (a_active && !m_HostsActive) Synchronise();
+	m_HostsActive = a_active;
+}
+
+void OsmiaParasitoid_Population_Manager::Synchronise()
+{
+	if (m_PendingDays == 0) return;
+	for (auto subpop : m_SubPopulations) {
+		subpop->SetSubPopnSize(subpop->GetSubPopnSize() * m_PendingSurvival);
+	}
+	unsigned species = unsigned(m_SubPopulations.size()) / m_Size;
+	for (unsigned sp = 0; sp < species; sp++) {
+		DisperseOverInterval(sp, m_PendingDays);
+	}
+	m_PendingDays = 0;
+	m_PendingSurvival = 1.0;
+}
+
+void OsmiaParasitoid_Population_Manager::DisperseOverInterval(unsigned a_species, int a_days)
+{
+	unsigned offset = a_species * m_Size;
+	// All cells of one species share the dispersal fraction
+	double d = m_SubPopulations[offset]->GetDiffusionRate();
+	int wide = int(m_Wide);
+	int high = int(m_High);
+	vector<double> now(m_Size), next(m_Size);
+	// Share of a cell's parasitoids sent to each neighbour (d over the number of neighbours)
+	vector<double> share(m_Size);
+	for (int y = 0; y < high; y++) {
+		for (int x = 0; x < wide; x++) {
+			int nx = min(x + 1, wide - 1) - max(x - 1, 0) + 1;
+			int ny = min(y + 1, high - 1) - max(y - 1, 0) + 1;
+			int neighbours = nx * ny - 1;
+			unsigned i = unsigned(x + y * wide);
+			now[i] = m_SubPopulations[offset + i]->GetSubPopnSize();
+			share[i] = (neighbours > 0) ? d / neighbours : 0.0;
+		}
+	}
+	for (int day = 0; day < a_days; day++) {
+		for (int y = 0; y < high; y++) {
+			int y0 = max(y - 1, 0), y1 = min(y + 1, high - 1);
+			for (int x = 0; x < wide; x++) {
+				int x0 = max(x - 1, 0), x1 = min(x + 1, wide - 1);
+				unsigned i = unsigned(x + y * wide);
+				double n = (share[i] > 0.0) ? now[i] * (1.0 - d) : now[i];
+				for (int ty = y0; ty <= y1; ty++) {
+					for (int tx = x0; tx <= x1; tx++) {
+						unsigned j = unsigned(tx + ty * wide);
+						if (j != i) n += now[j] * share[j];
+					}
+				}
+				next[i] = n;
+			}
+		}
+		now.swap(next);
+	}
+	for (unsigned i = 0; i < m_Size; i++) {
+		m_SubPopulations[offset + i]->SetSubPopnSize(now[i]);
+	}
+}
+
+//==============================================================================
+// PARASITOID CHANGE BUFFERS (Parallel step)
+//==============================================================================
+
+void OsmiaParasitoid_Population_Manager::ResetThreadBuffers(int a_threads)
+{
+	MergeThreadBuffers();
+	m_ThreadChanges.resize(a_threads > 0 ? unsigned(a_threads) : 1);
+}
+
+void OsmiaParasitoid_Population_Manager::MergeThreadBuffers()
+{
+	size_t total = 0;
+	for (auto& buffer : m_ThreadChanges) total += buffer.size();
+	if (total == 0) return;
+	vector<pair<unsigned, double>> changes;
+	changes.reserve(total);
+	for (auto& buffer : m_ThreadChanges) {
+		changes.insert(changes.end(), buffer.begin(), buffer.end());
+		buffer.clear();
+	}
+	// Sorting on both members fixes the order of floating point additions per cell
+	sort(changes.begin(), changes.end());
+	for (auto& change : changes) {
+		m_SubPopulations[change.first]->Add(change.second);
+	}
+}
+
+//==============================================================================
+// NEST CELL DEATH QUEUE
+//==============================================================================
+
+void Osmia_Nest_Manager::ProcessCellDeaths()
+{
+	for (auto& queue : m_CellDeathQueues) {
+		for (auto& cell : queue) {
+			TAnimal* occupant = cell.first->GetCellOccupant(cell.second);
+			// The alive bit was cleared when the cell was queued
+			if (occupant->GetCurrentStateNo() != -1) {
+				static_cast<Osmia_Base*>(occupant)->RemoveFromRaster();
+				occupant->KillThis();
+			}
+		}
+		queue.clear();
+	}
 }
 
+//==============================================================================
+// NEST CAPACITY (Initialisation and landscape change)
+//==============================================================================
+
+/**
+ * @brief Landscape element names accepted in the nests-by-habitat file
+ * @details The cavity-bearing habitats used by the default file, plus the field types so that
+ * they can be listed explicitly. Other types can be given by number.
+ */
+static const struct { const char* m_name; TTypesOfLandscapeElement m_type; } OsmiaNestHabitatNames[] = {
+	{ "tole_Hedges", tole_Hedges }, { "tole_HedgeBank", tole_HedgeBank }, { "tole_FieldBoundary", tole_FieldBoundary },
+	{ "tole_RoadsideVerge", tole_RoadsideVerge }, { "tole_RiversidePlants", tole_RiversidePlants },
+	{ "tole_Orchard", tole_Orchard }, { "tole_Garden", tole_Garden }, { "tole_Building", tole_Building },
+	{ "tole_UrbanPark", tole_UrbanPark }, { "tole_DeciduousForest", tole_DeciduousForest },
+	{ "tole_MixedForest", tole_MixedForest }, { "tole_ConiferousForest", tole_ConiferousForest },
+	{ "tole_YoungForest", tole_YoungForest }, { "tole_Copse", tole_Copse }, { "tole_Scrub", tole_Scrub },
+	{ "tole_NaturalGrassDry", tole_NaturalGrassDry }, { "tole_PermPasture", tole_PermPasture },
+	{ "tole_UnsprayedFieldMargin", tole_UnsprayedFieldMargin }, { "tole_Field", tole_Field }
+};
+
+/**
+ * @details Any malformed line, unknown name or out-of-range number stops the run with a warning
+ * giving the line number, rather than silently leaving a habitat unable to hold nests.
+ */
+void Osmia_Nest_Manager::ReadNestsByHabitat()
+{
+	for (int t = 0; t < tole_Foobar; t++) {
+		m_PossibleNestType[t] = false;
+		m_NestDensityByType[t] = 0.0;
+		m_NestProbByType[t] = 0.0;
+	}
+	ifstream ifile(cfg_OsmiaNestByLE_Datafile.value(), ios::in);
+	if (!ifile.is_open()) {
+		g_landscape_ptr->Warn("Osmia_Nest_Manager::ReadNestsByHabitat()", "cannot open nests by habitat file " + cfg_OsmiaNestByLE_Datafile.value());
+		std::exit(TOP_Osmia);
+	}
+	string line;
+	int lineno = 0;
+	while (getline(ifile, line)) {
+		lineno++;
+		istringstream fields(line);
+		string type;
+		if (!(fields >> type) || type[0] == '#') continue;
+		bool numeric = (type.find_first_not_of("0123456789") == string::npos);
+		double density, prob;
+		if (!(fields >> density) && numeric && fields.eof()) continue;  // A lone number is the entry count line of older files
+		if (fields.fail() || !(fields >> prob)) {
+			g_landscape_ptr->Warn("Osmia_Nest_Manager::ReadNestsByHabitat()", "malformed line " + to_string(lineno) + " in nests by habitat file");
+			std::exit(TOP_Osmia);
+		}
+		int le = -1;
+		if (numeric) le = atoi(type.c_str());
+		else {
+			for (const auto& name : OsmiaNestHabitatNames) {
+				if (type == name.m_name) le = int(name.m_type);
+			}
+		}
+		if (le < 0 || le >= tole_Foobar) {
+			g_landscape_ptr->Warn("Osmia_Nest_Manager::ReadNestsByHabitat()", "unknown landscape element type " + type + " on line " + to_string(lineno) + " in nests by habitat file");
+			std::exit(TOP_Osmia);
+		}
+		m_NestDensityByType[le] = density;
+		m_NestProbByType[le] = prob;
+		m_PossibleNestType[le] = (density > 0.0);
+	}
+	ifile.close();
+	m_NestTypeTablesSet = true;
+}
+
+/**
+ * @details Reads the per-type table (unless it has already come from a parameter bundle),
+ * allocates one OsmiaPolygonEntry and lock per polygon, then calls InitPolygonNesting() for
+ * each polygon.
+ */
+void Osmia_Nest_Manager::InitOsmiaBeeNesting()
+{
+	if (!m_NestTypeTablesSet) ReadNestsByHabitat();
+	int nopolys = g_landscape_ptr->SupplyNumberOfPolygons();
+	m_PolyList.resize(nopolys);
+	m_PolyListLocks.resize(nopolys);
+	m_NestCapablePolygons.clear();
+	m_FullPolygons = vector<std::atomic<uint64_t>>((nopolys + 63) / 64);
+	for (std::atomic<uint64_t>& word : m_FullPolygons) word.store(0);
+	for (int i = 0; i < nopolys; i++) {
+		m_PolyListLocks[i] = new omp_nest_lock_t;
+		omp_init_nest_lock(m_PolyListLocks[i]);
+		InitPolygonNesting(i, g_landscape_ptr->SupplyElementTypeFromVector(i));
+	}
+	BuildPolygonCellIndex();
+}
+
+/**
+ * @details Each thread scans a block of rows into its own run list; the lists are joined in row
+ * order and then bucketed by polygon with a counting sort, which keeps each polygon's runs in row
+ * order. Only types that can hold nests are indexed, which covers the founders and nest searching.
+ */
+void Osmia_Nest_Manager::BuildPolygonCellIndex()
+{
+	struct RowRun { int m_poly; int m_x; int m_y; int m_length; };
+	int nopolys = int(m_PolyList.size());
+	vector<char> indexed(nopolys);
+	for (int i = 0; i < nopolys; i++) indexed[i] = m_PossibleNestType[g_landscape_ptr->SupplyElementTypeFromVector(i)];
+	int threads = omp_get_max_threads();
+	vector<vector<RowRun>> blocks(threads);
+	#pragma omp parallel for schedule(static, 1)
+	for (int b = 0; b < threads; b++) {
+		int y0 = int(int64_t(SimH) * b / threads), y1 = int(int64_t(SimH) * (b + 1) / threads);
+		for (int y = y0; y < y1; y++) {
+			int x = 0;
+			while (x < SimW) {
+				int poly = g_landscape_ptr->SupplyPolyRefIndex(x, y);
+				int start = x;
+				while (++x < SimW && g_landscape_ptr->SupplyPolyRefIndex(x, y) == poly);
+				if (indexed[poly]) blocks[b].push_back(RowRun{ poly, start, y, x - start });
+			}
+		}
+	}
+	m_CellRunStart.assign(nopolys + 1, 0);
+	m_PolygonCells.assign(nopolys, 0);
+	for (auto& block : blocks) for (const RowRun& r : block) m_CellRunStart[r.m_poly + 1]++;
+	for (int i = 0; i < nopolys; i++) m_CellRunStart[i + 1] += m_CellRunStart[i];
+	m_CellRuns.resize(m_CellRunStart[nopolys]);
+	vector<unsigned> next(m_CellRunStart.begin(), m_CellRunStart.end() - 1);
+	for (auto& block : blocks) {
+		for (const RowRun& r : block) {
+			m_CellRuns[next[r.m_poly]++] = CellRun{ r.m_x, r.m_y, m_PolygonCells[r.m_poly] };
+			m_PolygonCells[r.m_poly] += unsigned(r.m_length);
+		}
+	}
+}
+
+APoint Osmia_Nest_Manager::SupplyRandomLocation(int a_polyindex) const
+{
+	if (m_CellRunStart.empty() || m_PolygonCells[a_polyindex] == 0) return g_landscape_ptr->SupplyARandomLocPoly(a_polyindex);
+	unsigned cell = unsigned(g_random_fnc(int(m_PolygonCells[a_polyindex])));
+	const CellRun* first = m_CellRuns.data() + m_CellRunStart[a_polyindex];
+	const CellRun* last = m_CellRuns.data() + m_CellRunStart[a_polyindex + 1];
+	// Last run starting at or before the chosen cell
+	const CellRun* run = upper_bound(first, last, cell, [](unsigned a_cell, const CellRun& a_run) { return a_cell < a_run.m_before; }) - 1;
+	APoint pt;
+	pt.m_x = run->m_x + int(cell - run->m_before);
+	pt.m_y = run->m_y;
+	return pt;
+}
+
+/**
+ * @details The aspect band comes from the nest's aspect delay, which already encodes how much cooler
+ * the site is than average. Woodland and hedgerow element types count as shaded habitat. With the
+ * microclimate layer off every nest is given the neutral open class, whose offset is ignored.
+ */
+uint8_t Osmia_Nest_Manager::ClassifyMicroclimate(Osmia_Nest* a_nest, int a_polyindex)
+{
+	if (!cfg_OsmiaMicroclimate.value()) return 1;
+	int delay = a_nest->GetAspectDelay();
+	int aspect = (delay < cfg_OsmiaMicroclimateAspectCuts.value(0)) ? 0 : ((delay > cfg_OsmiaMicroclimateAspectCuts.value(1)) ? 2 : 1);
+	int shaded = 0;
+	switch (g_landscape_ptr->SupplyElementTypeFromVector(a_polyindex)) {
+	case tole_DeciduousForest:
+	case tole_ConiferousForest:
+	case tole_MixedForest:
+	case tole_YoungForest:
+	case tole_Hedges:
+	case tole_HedgeBank:
+		shaded = 1;
+		break;
+	default:
+		break;
+	}
+	return uint8_t(aspect + 3 * shaded);
+}
+
+void Osmia_Nest_Manager::InitPolygonNesting(int a_polyindex, TTypesOfLandscapeElement a_type)
+{
+	double area_ha = g_landscape_ptr->SupplyPolygonAreaVector(a_polyindex) / 10000.0;
+	int maxnests = int(area_ha * m_NestDensityByType[int(a_type)]);
+	OsmiaPolygonEntry& entry = m_PolyList[a_polyindex];
+	entry.SetMaxNests(maxnests);
+	entry.SetOsmiaNestProb(m_NestProbByType[int(a_type)]);
+	SetPolygonFull(a_polyindex, !entry.HasNestCapacity());
+	if (maxnests > 0) m_NestCapablePolygons.push_back(a_polyindex);
+}
+
+//==============================================================================
+// PARAMETER TABLES AND BINARY BUNDLE
+//==============================================================================
+
+void Osmia_Population_Manager::BuildParameterTables()
+{
+	// Read monthly pollen and nectar thresholds
+	OsmiaPollenNectarThresholds pnt;
+	for (int m = 0; m < 12; m++) {
+		pnt.m_pollenTquan = cfg_OsmiaPollenThresholds.value(m);
+		pnt.m_pollenTqual = cfg_OsmiaPollenThresholds.value(m + 12);
+		pnt.m_nectarTquan = cfg_OsmiaNectarThresholds.value(m);
+		pnt.m_nectarTqual = cfg_OsmiaNectarThresholds.value(m + 12);
+		m_PN_thresholds.push_back(pnt);
+	}
+	
+	// Build sex ratio and cocoon mass lookup tables
+	vector<double> params_logistic, params_lin, params_logistic2, params_lin2;
+	params_logistic = cfg_OsmiaSexRatioVsMotherAgeLogistic.value();
+	params_lin = cfg_OsmiaSexRatioVsMotherMassLinear.value();
+	params_lin2 = Cfg_OsmiaFemaleCocoonMassVsMotherMassLinear.value();
+	params_logistic2 = Cfg_OsmiaFemaleCocoonMassVsMotherAgeLogistic.value();
+	const double halfmassloss = cfg_Osmia_LifetimeCocoonMassLoss.value() / 2.0;
+	const double provfromcocoon = cfg_OsmiaProvMassFromCocoonMass.value();
+	const unsigned noages = 61;
+
+	// The logistic denominators depend only on age, so the exp calls are made once per age
+	// rather than once per mass class and age
+	double sexdenom[noages], cocoondenom[noages];
+	for (unsigned age = 0; age < noages; age++) {
+		sexdenom[age] = 1 + exp(-params_logistic[3] * (age - params_logistic[0]));
+		cocoondenom[age] = 1 + exp(-params_logistic2[3] * (age - params_logistic2[0]));
+	}
+
+	// Note: Uses 0.25 mg step despite cfg_OsmiaAdultMassCategoryStep = 10.0
+	// The mass classes are accumulated serially so their values match the original running sum
+	vector<double> masses;
+	for (double mass = cfg_OsmiaFemaleMassMin.value(); 
+	     mass <= cfg_OsmiaFemaleMassMax.value(); 
+	     mass += 0.25) {  // HARDCODED step size (not from config!)
+		masses.push_back(mass);
+	}
+	m_EggSexRatioEqns.assign(masses.size(), eggsexratiovsagelogisticcurvedata(noages));
+	m_FemaleCocoonMassEqns.assign(masses.size(), femalecocoonmassvsagelogisticcurvedata(noages));
+
+	// Each mass class writes only its own pair of curves, so the classes are filled in parallel
+	#pragma omp parallel for schedule(static)
+	for (int m = 0; m < int(masses.size()); m++) {
+		// Sex ratio calculation: Logistic(age, adjusted_max)
+		double adjustedmax = params_lin[0] * masses[m] + params_lin[1];
+		// Cocoon mass calculation: Logistic(age, mass-adjusted baseline)
+		double avg_female_cocoon_mass = params_lin2[0] * masses[m] + params_lin2[1];
+		double first_female_cocoon_mass = avg_female_cocoon_mass + halfmassloss;
+		double* curve1 = m_EggSexRatioEqns[m].data();
+		double* curve2 = m_FemaleCocoonMassEqns[m].data();
+#ifdef OSMIA_OMP_SIMD
+		#pragma omp simd
+#endif
+		for (unsigned age = 0; age < noages; age++) {
+			curve1[age] = params_logistic[1] + (adjustedmax - params_logistic[1]) / sexdenom[age];
+			// Convert to provisioning mass
+			curve2[age] = 40.0 + (provfromcocoon * (params_logistic2[1] + (first_female_cocoon_mass - params_logistic2[1]) / cocoondenom[age]));
+		}
+	}
+	
+	// Build provisioning time lookup table
+	const double e = exp(1.0);
+	for (int d = 0; d < 365; d++) {
+		// Seidelmann (2006) provisioning efficiency equation
+		double eff = 21.643 / (1 + pow(e, (log(d) - log(18.888)) * 3.571));  // mg/h
+		double constructime = (2.576 * eff + 56.17) / eff;  // hours per cell
+		m_NestProvisioningParameters.Set(d, int(constructime));
+	}
+	
+	// Populate prepupal development rate lookup table
+	for (int i = 0; i < int(OsmiaTemperatureTable::Size()); i++) {
+		m_PrePupalDevelRates.Set(i, cfg_OsmiaPrepupalDevelRates.value(i));
+	}
+	
+	// Build foraging efficiency lookup table, covering every age the table can be read at
+	vector<double> forage(OsmiaAgeTable::Size());
+	forage[0] = 0;  // Age 0: no foraging
+	for (int i = 1; i < int(forage.size()); i++) {
+		forage[i] = 21.643 / (1 + exp((log(i) - log(18.888)) * 3.571));
+	}
+	Osmia_Female::SetForageEfficiency(forage.data(), forage.size());
+}
+
+/**
+ * @details Every value that BuildParameterTables() or ReadNestsByHabitat() reads goes into
+ * the hash, so any edit to a configuration entry or to the nests file changes it.
+ */
+uint64_t Osmia_Population_Manager::ComputeParameterFingerprint()
+{
+	uint32_t build[3] = { OsmiaParameterBundle::m_SchemaVersion, uint32_t(sizeof(double)), uint32_t(tole_Foobar) };
+	uint64_t h = OsmiaParameterBundle::Hash(build, sizeof(build));
+	vector<vector<double>> arrays = {
+		cfg_OsmiaPollenThresholds.value(), cfg_OsmiaNectarThresholds.value(),
+		cfg_OsmiaPrepupalDevelRates.value(),
+		cfg_OsmiaSexRatioVsMotherAgeLogistic.value(), cfg_OsmiaSexRatioVsMotherMassLinear.value(),
+		Cfg_OsmiaFemaleCocoonMassVsMotherAgeLogistic.value(), Cfg_OsmiaFemaleCocoonMassVsMotherMassLinear.value()
+	};
+	for (auto& a : arrays) {
+		uint64_t n = a.size();
+		h = OsmiaParameterBundle::Hash(&n, sizeof(n), h);
+		if (n > 0) h = OsmiaParameterBundle::Hash(a.data(), a.size() * sizeof(double), h);
+	}
+	double scalars[4] = { cfg_OsmiaFemaleMassMin.value(), cfg_OsmiaFemaleMassMax.value(),
+		cfg_Osmia_LifetimeCocoonMassLoss.value(), cfg_OsmiaProvMassFromCocoonMass.value() };
+	h = OsmiaParameterBundle::Hash(scalars, sizeof(scalars), h);
+	ifstream nestfile(cfg_OsmiaNestByLE_Datafile.value(), ios::in | ios::binary);
+	if (nestfile.is_open()) {
+		string bytes((istreambuf_iterator<char>(nestfile)), istreambuf_iterator<char>());
+		h = OsmiaParameterBundle::Hash(bytes.data(), bytes.size(), h);
+	}
+	return h;
+}
+
+void Osmia_Population_Manager::CaptureParameterBundle(OsmiaParameterBundle& a_bundle)
+{
+	const double* density = m_OurOsmiaNestManager.GetNestDensityByType();
+	const double* prob = m_OurOsmiaNestManager.GetNestProbByType();
+	a_bundle.SetSection(OsmiaParameterBundle::obs_NestDensityByType, vector<double>(density, density + tole_Foobar));
+	a_bundle.SetSection(OsmiaParameterBundle::obs_NestProbByType, vector<double>(prob, prob + tole_Foobar));
+	vector<double> pnt;
+	for (auto& t : m_PN_thresholds) {
+		pnt.push_back(t.m_pollenTquan);
+		pnt.push_back(t.m_pollenTqual);
+		pnt.push_back(t.m_nectarTquan);
+		pnt.push_back(t.m_nectarTqual);
+	}
+	a_bundle.SetSection(OsmiaParameterBundle::obs_PNThresholds, pnt);
+	a_bundle.SetSection(OsmiaParameterBundle::obs_PrePupalDevelRates, vector<double>(m_PrePupalDevelRates.Data(), m_PrePupalDevelRates.Data() + OsmiaTemperatureTable::Size()));
+	a_bundle.m_NoAgeClasses = m_EggSexRatioEqns.empty() ? 0 : unsigned(m_EggSexRatioEqns[0].size());
+	vector<double> sexratio, cocoonmass;
+	for (auto& curve : m_EggSexRatioEqns) sexratio.insert(sexratio.end(), curve.begin(), curve.end());
+	for (auto& curve : m_FemaleCocoonMassEqns) cocoonmass.insert(cocoonmass.end(), curve.begin(), curve.end());
+	a_bundle.SetSection(OsmiaParameterBundle::obs_EggSexRatio, sexratio);
+	a_bundle.SetSection(OsmiaParameterBundle::obs_FemaleCocoonMass, cocoonmass);
+	a_bundle.SetSection(OsmiaParameterBundle::obs_NestProvisioning, vector<double>(m_NestProvisioningParameters.Data(), m_NestProvisioningParameters.Data() + OsmiaAgeTable::Size()));
+	const OsmiaAgeTable& forage = Osmia_Female::GetForageEfficiencyTable();
+	a_bundle.SetSection(OsmiaParameterBundle::obs_ForageEfficiency, vector<double>(forage.Data(), forage.Data() + OsmiaAgeTable::Size()));
+}
+
+bool Osmia_Population_Manager::ApplyParameterBundle(const OsmiaParameterBundle& a_bundle)
+{
+	const vector<double>& density = a_bundle.GetSection(OsmiaParameterBundle::obs_NestDensityByType);
+	const vector<double>& prob = a_bundle.GetSection(OsmiaParameterBundle::obs_NestProbByType);
+	const vector<double>& pnt = a_bundle.GetSection(OsmiaParameterBundle::obs_PNThresholds);
+	const vector<double>& prepupal = a_bundle.GetSection(OsmiaParameterBundle::obs_PrePupalDevelRates);
+	const vector<double>& sexratio = a_bundle.GetSection(OsmiaParameterBundle::obs_EggSexRatio);
+	const vector<double>& cocoonmass = a_bundle.GetSection(OsmiaParameterBundle::obs_FemaleCocoonMass);
+	const vector<double>& provisioning = a_bundle.GetSection(OsmiaParameterBundle::obs_NestProvisioning);
+	const vector<double>& forage = a_bundle.GetSection(OsmiaParameterBundle::obs_ForageEfficiency);
+	unsigned ages = a_bundle.m_NoAgeClasses;
+	if (density.size() != unsigned(tole_Foobar) || prob.size() != unsigned(tole_Foobar) || pnt.size() != 48
+		|| prepupal.size() != OsmiaTemperatureTable::Size() || provisioning.size() != OsmiaAgeTable::Size() || forage.empty()
+		|| ages == 0 || sexratio.size() % ages != 0 || cocoonmass.size() != sexratio.size()) return false;
+
+	m_OurOsmiaNestManager.SetNestTypeTables(density.data(), prob.data());
+	m_PN_thresholds.clear();
+	for (int m = 0; m < 12; m++) {
+		OsmiaPollenNectarThresholds t;
+		t.m_pollenTquan = pnt[m * 4];
+		t.m_pollenTqual = pnt[m * 4 + 1];
+		t.m_nectarTquan = pnt[m * 4 + 2];
+		t.m_nectarTqual = pnt[m * 4 + 3];
+		m_PN_thresholds.push_back(t);
+	}
+	m_PrePupalDevelRates.Fill(prepupal.data(), prepupal.size());
+	m_EggSexRatioEqns.clear();
+	m_FemaleCocoonMassEqns.clear();
+	for (size_t i = 0; i < sexratio.size(); i += ages) {
+		m_EggSexRatioEqns.push_back(eggsexratiovsagelogisticcurvedata(sexratio.begin() + i, sexratio.begin() + i + ages));
+		m_FemaleCocoonMassEqns.push_back(femalecocoonmassvsagelogisticcurvedata(cocoonmass.begin() + i, cocoonmass.begin() + i + ages));
+	}
+	m_NestProvisioningParameters.Fill(provisioning.data(), provisioning.size());
+	Osmia_Female::SetForageEfficiency(forage.data(), forage.size());
+	return true;
+}
+
+bool OsmiaWriteFileAtomically(const string& a_filename, const std::function<void(ostream&)>& a_writer, bool a_binary)
+{
+	static std::atomic<unsigned long> counter(0);
+	unsigned long n = ++counter;
+#if defined(_WIN32)
+	long pid = long(_getpid());
+#else
+	long pid = long(getpid());
+#endif
+	string tmpname = a_filename + "." + to_string(pid) + "." + to_string(n) + ".tmp";
+	{
+		ofstream ofile(tmpname, a_binary ? (ios::out | ios::binary | ios::trunc) : (ios::out | ios::trunc));
+		if (!ofile.is_open()) return false;
+		a_writer(ofile);
+		ofile.close();
+		if (ofile.fail()) {
+			remove(tmpname.c_str());
+			return false;
+		}
+	}
+#if defined(_WIN32)
+	// rename() will not replace an existing file on Windows
+	bool ok = MoveFileExA(tmpname.c_str(), a_filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	bool ok = rename(tmpname.c_str(), a_filename.c_str()) == 0;
+#endif
+	if (!ok) remove(tmpname.c_str());
+	return ok;
+}
+
+uint64_t OsmiaParameterBundle::Hash(const void* a_data, size_t a_size, uint64_t a_hash)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(a_data);
+	for (size_t i = 0; i < a_size; i++) {
+		a_hash ^= bytes[i];
+		a_hash *= 1099511628211ULL;
+	}
+	return a_hash;
+}
+
+bool OsmiaParameterBundle::Load(const string& a_filename, uint64_t a_fingerprint)
+{
+	ifstream ifile(a_filename, ios::in | ios::binary);
+	if (!ifile.is_open()) return false;
+	Header header;
+	if (!ifile.read(reinterpret_cast<char*>(&header), sizeof(Header))) return false;
+	if (header.m_magic != m_Magic || header.m_schema != m_SchemaVersion || header.m_fingerprint != a_fingerprint) return false;
+	// The section table must describe exactly the bytes that follow the header
+	ifile.seekg(0, ios::end);
+	streamoff filesize = ifile.tellg();
+	if (filesize < streamoff(sizeof(Header))) return false;
+	uint64_t available = uint64_t(filesize - streamoff(sizeof(Header))) / sizeof(double);
+	uint64_t total = 0;
+	for (unsigned s = 0; s < obs_foobar; s++) {
+		if (header.m_offset[s] != total || header.m_length[s] > available - total) return false;
+		total += header.m_length[s];
+	}
+	if (total * sizeof(double) != uint64_t(filesize) - sizeof(Header)) return false;
+	ifile.seekg(sizeof(Header), ios::beg);
+	vector<double> payload(total);
+	if (total > 0 && !ifile.read(reinterpret_cast<char*>(payload.data()), total * sizeof(double))) return false;
+	if (Hash(payload.data(), payload.size() * sizeof(double)) != header.m_checksum) return false;
+	for (unsigned s = 0; s < obs_foobar; s++) {
+		m_Sections[s].assign(payload.begin() + header.m_offset[s], payload.begin() + header.m_offset[s] + header.m_length[s]);
+	}
+	m_NoAgeClasses = header.m_noageclasses;
+	return true;
+}
+
+bool OsmiaParameterBundle::Save(const string& a_filename, uint64_t a_fingerprint) const
+{
+	Header header;
+	header.m_magic = m_Magic;
+	header.m_schema = m_SchemaVersion;
+	header.m_fingerprint = a_fingerprint;
+	header.m_noageclasses = m_NoAgeClasses;
+	header.m_reserved = 0;
+	vector<double> payload;
+	for (unsigned s = 0; s < obs_foobar; s++) {
+		header.m_offset[s] = payload.size();
+		header.m_length[s] = m_Sections[s].size();
+		payload.insert(payload.end(), m_Sections[s].begin(), m_Sections[s].end());
+	}
+	header.m_checksum = Hash(payload.data(), payload.size() * sizeof(double));
+	return OsmiaWriteFileAtomically(a_filename, [&](ostream& a_out) {
+		a_out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		a_out.write(reinterpret_cast<const char*>(payload.data()), payload.size() * sizeof(double));
+	});
+}
@@ -67,6 +67,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include <forward_list>
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <atomic>
+#ifdef __OSMIA_METRICS
+#include <chrono>
+#endif
 
 //---------------------------------------------------------------------------
 #ifndef Osmia_Population_ManagerH
@@ -335,8 +342,30 @@ public:
 	 * @return Number of parasitoids in this cell
 	 */
 	double GetSubPopnSize() { return m_NoParasitoids; }
-	
-	/** 
+
+	/**
+	 * @brief Overwrite current population size
+	 * @param a_number New number of parasitoids in this cell
+	 * @details Used by the macro-step integrator, which calculates the new cell
+	 * totals for the whole grid at once and writes them back.
+	 */
+	void SetSubPopnSize(double a_number) { m_NoParasitoids = a_number; }
+
+	/**
+	 * @brief Query daily dispersal fraction
+	 * @return Proportion of this cell's population dispersing per day
+	 */
+	double GetDiffusionRate() { return m_DiffusionRate; }
+
+	/**
+	 * @brief Query the daily mortality rate for the current month
+	 * @return Proportion of the population dying per day this month
+	 * @details Mortality is uniform across cells, so the manager can integrate it
+	 * as a single scalar survival factor over any number of days.
+	 */
+	static double GetMortalityThisMonth() { return m_MortalityPerMonth[m_ThisMonth]; }
+
+	/**
 	 * @brief Apply daily mortality
 	 * @details Removes proportion m_MortalityPerMonth[m_ThisMonth] of population.
 	 * Stochastic mortality at individual level; deterministic at population level.
@@ -356,6 +385,7 @@ public:
 	 * @details Queries landscape for local *Osmia* nest density, calculates offspring
 	 * production using functional response, adds offspring to population. Reproduction
 	 * success depends on host encounter rate (search efficiency × host density).
+	 * Only called on days with active hosts (see DoFirst()).
 	 */
 	void Reproduce();
 	
@@ -364,15 +394,20 @@ public:
 	 * @details Calls processes in biologically meaningful order:
 	 * 1. DailyMortality() - deaths from all causes
 	 * 2. Dispersal() - movement of survivors
-	 * 3. Reproduce() - offspring production
+	 * 3. Reproduce() - offspring production, only while
+	 *    OsmiaParasitoid_Population_Manager::AreHostsActive()
+	 * 
+	 * Outside the flying season the nests hold only sealed cocoons, which the parasitoids
+	 * cannot oviposit into, so reproduction is zero by rule rather than left to the local
+	 * nest density. This is what lets macro-stepping integrate mortality and dispersal only.
+	 * 
+	 * Does nothing on days the population manager has deferred for macro-stepping
+	 * (OsmiaParasitoid_Population_Manager::IsDayDeferred()); those days are applied to the
+	 * whole grid at once by OsmiaParasitoid_Population_Manager::Synchronise().
 	 * 
 	 * Virtual to allow derived classes to modify or extend process sequence.
 	 */
-	virtual void DoFirst() {
-		DailyMortality();
-		Dispersal();
-		Reproduce();
-	}
+	virtual void DoFirst();
 	
 	/** 
 	 * @brief Update current month for mortality lookup
@@ -419,7 +454,16 @@ public:
  * 
  * Typical choice (1 km cells) balances parasitoid dispersal scales (hundreds of meters
  * per day) against simulation performance for landscape-scale studies.
- * 
+ *
+ * @par Macro-Stepping Outside the Nesting Season
+ * When OSMIA_PARAS_MACROSTEP is set, days on which no bee hosts are active (no adult
+ * females and no spring emergence) are not simulated cell by cell. The manager only
+ * accumulates the product of daily survival and the number of days skipped. The grid
+ * is brought up to date in one pass, using closed-form exponential decay and the daily
+ * dispersal operator applied once per skipped day, as soon as the *Osmia* manager reports
+ * host activity again. The sub-populations do not reproduce while hosts are inactive,
+ * in daily mode too, so only mortality and dispersal need integrating.
+ *
  * @see OsmiaParasitoidSubPopulation for individual cell dynamics
  */
 class OsmiaParasitoid_Population_Manager : public Population_Manager
@@ -462,7 +506,58 @@ protected:
 	 * @details m_Size = m_Wide × m_High. Pre-calculated for efficiency in index arithmetic.
 	 */
 	unsigned m_Size;
-	
+
+	/**
+	 * @brief Whether *Osmia* hosts were active at the last report from the bee manager
+	 * @details Set via SetHostsActive(). Defaults to true so that the daily model is
+	 * used until the bee manager says otherwise.
+	 */
+	bool m_HostsActive = true;
+
+	/** @brief Number of days accumulated but not yet applied to the grid */
+	int m_PendingDays = 0;
+
+	/** @brief true if today was deferred by DoFirst() and the cells must not step */
+	bool m_DayDeferred = false;
+
+	/**
+	 * @brief Product of daily survival over the pending days
+	 * @details Mortality is uniform across cells, so the closed-form decay over the
+	 * interval is a single scalar: the product of (1 - m) for each pending day.
+	 */
+	double m_PendingSurvival = 1.0;
+
+	/**
+	 * @brief Per-thread sparse buffers of (sub-population index, change) pairs
+	 * @details Filled by QueueChange() during the parallel step, one vector per OpenMP
+	 * thread so no locking or atomics are needed. Emptied by MergeThreadBuffers().
+	 */
+	vector<vector<pair<unsigned, double>>> m_ThreadChanges;
+
+	/**
+	 * @brief Record a change to one sub-population
+	 * @param a_ref Sub-population array index
+	 * @param a_change Number of parasitoids to add (negative to remove)
+	 * @details Outside a parallel region the change is applied directly. Inside one it
+	 * goes to the calling thread's buffer. A thread without a buffer (thread count raised
+	 * without ResetThreadBuffers()) falls back to a critical section, which is race-free
+	 * but not order-deterministic.
+	 */
+	void QueueChange(unsigned a_ref, double a_change) {
+		if (!omp_in_parallel()) {
+			m_SubPopulations[a_ref]->Add(a_change);
+			return;
+		}
+		unsigned thread = unsigned(omp_get_thread_num());
+		if (thread < m_ThreadChanges.size()) {
+			m_ThreadChanges[thread].push_back(make_pair(a_ref, a_change));
+		}
+		else {
+#pragma omp critical (OsmiaParasitoidChange)
+			m_SubPopulations[a_ref]->Add(a_change);
+		}
+	}
+
 	// Methods
 public:
 	/**
@@ -505,7 +600,7 @@ public:
 	 * @details Used for emigration or mortality affecting specific cells.
 	 */
 	void RemoveParasitoids(int a_ref, double a_dispersers) {
-		m_SubPopulations[a_ref]->Remove(a_dispersers);
+		QueueChange(unsigned(a_ref), -a_dispersers);
 	}
 	
 	/**
@@ -540,6 +635,9 @@ public:
 	 */
 	array<double, static_cast<unsigned>(TTypeOfOsmiaParasitoids::topara_foobar)> 
 	GetParasitoidNumbers(int a_x, int a_y);
+
+	/** @brief Grid cell size in metres */
+	unsigned GetCellSize() { return m_CellSize; }
 	
 	/**
 	 * @brief Add one parasitoid of specified type at location
@@ -551,13 +649,81 @@ public:
 	 * calculates sub-population index accounting for species offset, adds
 	 * parasitoid to appropriate sub-population.
 	 * 
-	 * Used during parasitoid reproduction or initialization.
+	 * Used during parasitoid reproduction or initialization. Bees call this from
+	 * Osmia_InCocoon::st_Emerge() inside the parallel step, so the change is queued
+	 * through QueueChange() rather than applied to the shared cell directly.
 	 */
 	void AddParasitoid(TTypeOfOsmiaParasitoids a_type, int a_x, int a_y) {
-		int subpop = ((a_x / m_CellSize) + (a_y / m_CellSize) * m_Wide) 
+		int subpop = ((a_x / m_CellSize) + (a_y / m_CellSize) * m_Wide)
 		           + (static_cast<unsigned>(a_type)-1) * m_Size;
-		m_SubPopulations[subpop]->Add(1);
+		QueueChange(unsigned(subpop), 1.0);
 	}
+
+	/**
+	 * @brief Size the per-thread change buffers
+	 * @param a_threads Number of threads that may call AddParasitoid() or RemoveParasitoids()
+	 * @details Must be called from serial code before the first parallel step, and again
+	 * if the thread count changes. Any changes still buffered are merged first.
+	 */
+	void ResetThreadBuffers(int a_threads);
+
+	/**
+	 * @brief Apply all buffered parasitoid changes to the grid
+	 * @details Entries from all threads are gathered and sorted by (cell, change) before
+	 * they are applied. The result therefore does not depend on which thread handled
+	 * which bee, or in what order, and repeated runs are bit-identical. Must be called
+	 * from serial code; called by the *Osmia* manager at the start of its DoLast() and
+	 * by DoFirst() here.
+	 */
+	void MergeThreadBuffers();
+
+	/**
+	 * @brief Daily update of the parasitoid grid
+	 * @details With macro-stepping off, or on days with host activity, any pending
+	 * interval is applied so that the sub-populations step from an up-to-date grid.
+	 * On host-free days with macro-stepping on, the day is only recorded in
+	 * m_PendingDays and m_PendingSurvival, and IsDayDeferred() tells the
+	 * sub-populations not to step. The sub-populations themselves are stepped by the
+	 * framework, as before, not from here.
+	 */
+	virtual void DoFirst();
+
+	/** @brief true if bee hosts were active at the last report (see SetHostsActive()) */
+	bool AreHostsActive() const { return m_HostsActive; }
+
+	/** @brief true if today is held over for Synchronise() and the cells must not step */
+	bool IsDayDeferred() const { return m_DayDeferred; }
+
+	/**
+	 * @brief Report whether bee hosts are active today
+	 * @param a_active true if adult females are present or spring emergence is under way
+	 * @details Called by the *Osmia* population manager in its DoFirst(). A switch to
+	 * active synchronises the grid immediately, so that no bee ever reads or adds to a
+	 * cell that still has days of decay and dispersal outstanding.
+	 */
+	void SetHostsActive(bool a_active);
+
+	/**
+	 * @brief Apply all pending days to the grid in a single pass
+	 * @details Multiplies every cell by m_PendingSurvival and disperses each species
+	 * layer over m_PendingDays days. Does nothing if no days
+	 * are pending. Must be called from serial code.
+	 */
+	void Synchronise();
+
+protected:
+	/**
+	 * @brief Disperse one species layer over a number of days
+	 * @param a_species Zero-based parasitoid species index
+	 * @param a_days Number of days of dispersal to apply
+	 * @details Applies the daily dispersal rule once per day to a plain array of cell
+	 * sizes. Each day a cell keeps (1 - d) of its parasitoids and shares d equally among
+	 * its neighbours. Edge cells have fewer neighbours (as in the sub-population
+	 * constructor), so each of them receives a larger share, and nothing leaves the grid.
+	 * Mortality is uniform across cells and commutes with dispersal, so it is applied
+	 * separately by Synchronise().
+	 */
+	void DisperseOverInterval(unsigned a_species, int a_days);
 };
 
 //==============================================================================
@@ -657,6 +823,14 @@ class struct_Osmia
 	 * to their spatial-temporal context within the nest structure.
 	 */
 	Osmia_Nest* nest;
+
+	/**
+	 * @brief Slot index of the individual's cell in the nest (laying order)
+	 * @details Copied from Osmia_Base::m_NestSlot on each life-stage transition so the
+	 * new object occupies the same cell. -1 when there is no cell yet (the slot for a
+	 * new egg or initial cocoon is assigned by the nest in CreateObjects()).
+	 */
+	int nestslot = -1;
 	
 	/** 
 	 * @brief Parasitism status
@@ -720,6 +894,23 @@ class struct_Osmia
 	 * Should be 0.0 for normal simulation where population initialized from eggs.
 	 */
 	double overwintering_degree_days = 0.0;
+
+	/**
+	 * @brief Species index (see OsmiaSpeciesTraits)
+	 * @details Set by CreateObjects() from the calling individual, so eggs take their mother's
+	 * species and every later stage keeps it. Founders are assigned by PickFounderSpecies().
+	 */
+	uint8_t species = 0;
+
+#ifdef __OSMIA_LINEAGE
+	/**
+	 * @brief Lineage identifier carried through life-stage transitions
+	 * @details Copied from Osmia_Base::m_LineageID on each transition, so an individual keeps
+	 * its identifier from egg to adult. New eggs are given a fresh identifier by CreateObjects(),
+	 * which takes the mother's from the laying female itself. 0 = not logged.
+	 */
+	uint64_t lineageid = 0;
+#endif
 };
 
 //==============================================================================
@@ -786,7 +977,7 @@ protected:
 	 * Can be static (read from habitat classification) or dynamic (modified by
 	 * management events, vegetation succession, or density-dependent effects).
 	 */
-	double m_OsmiaNestProb;
+	double m_OsmiaNestProb = 0.0;
 	
 	/** 
 	 * @brief Maximum number of nests possible in this polygon
@@ -802,12 +993,12 @@ protected:
 	 * areas have none (Gathmann and Tscharntke 2002).
 	 * 
 	 * Calculated from polygon area, habitat type, and density parameters during
-	 * initialization.
+	 * initialization (Osmia_Nest_Manager::InitPolygonNesting()).
 	 */
-	int m_MaxNests;
+	int m_MaxNests = 0;
 	
 	/** @brief Current number of active nests in this polygon */
-	int m_CurrentNestCount;
+	int m_CurrentNestCount = 0;
 
 public:
 	/**
@@ -949,9 +1140,62 @@ public:
 	 * @par File Format
 	 * Configuration file specifies nest capacity per polygon based on habitat type
 	 * and management. Typical values range from 0 (unsuitable) to 100s (nest boxes).
+	 * See ReadNestsByHabitat() for the layout.
 	 */
 	void InitOsmiaBeeNesting();
 
+	/**
+	 * @brief Parse the nests-by-habitat file into the per-type tables
+	 * @details Called by InitOsmiaBeeNesting() unless the tables have already been set from
+	 * a parameter bundle via SetNestTypeTables().
+	 *
+	 * @par File Format
+	 * One habitat type per line: `type max_nests_per_hectare nesting_probability`, where type
+	 * is a landscape element name as listed in ReadNestsByHabitat()'s name table (e.g.
+	 * `tole_Hedges`) or a TTypesOfLandscapeElement number. Blank lines and lines starting with
+	 * `#` are skipped, and so is a line holding a single number, so files that start with the
+	 * entry count are still read. Types not listed cannot hold nests. The default file,
+	 * OsmiaNestsByHabitat.txt, is shipped with the sources.
+	 */
+	void ReadNestsByHabitat();
+
+	/**
+	 * @brief Set the per-type nest tables directly (from a parameter bundle)
+	 * @param a_density Maximum nests per hectare, tole_Foobar entries
+	 * @param a_prob Nesting probability, tole_Foobar entries
+	 */
+	void SetNestTypeTables(const double* a_density, const double* a_prob) {
+		for (int t = 0; t < tole_Foobar; t++) {
+			m_NestDensityByType[t] = a_density[t];
+			m_NestProbByType[t] = a_prob[t];
+			m_PossibleNestType[t] = (a_density[t] > 0.0);
+		}
+		m_NestTypeTablesSet = true;
+	}
+
+	/** @brief Get the per-type maximum nests per hectare table (tole_Foobar entries) */
+	const double* GetNestDensityByType() { return m_NestDensityByType; }
+
+	/** @brief Get the per-type nesting probability table (tole_Foobar entries) */
+	const double* GetNestProbByType() { return m_NestProbByType; }
+
+	/**
+	 * @brief Set the nesting capacity of one polygon from its type
+	 * @param a_polyindex Polygon index
+	 * @param a_type Landscape element type of the polygon
+	 *
+	 * @details Sets maximum nests and nesting probability from the per-type tables and adds the
+	 * polygon to the nest-capable index if it can hold nests. Called once per polygon, in index
+	 * order, from InitOsmiaBeeNesting(); capacity does not change during a run.
+	 */
+	void InitPolygonNesting(int a_polyindex, TTypesOfLandscapeElement a_type);
+
+	/**
+	 * @brief Get the index of polygons that can currently hold nests
+	 * @return Polygon indices with a maximum nest count above zero, in ascending order
+	 */
+	const vector<int>& GetNestCapablePolygons() { return m_NestCapablePolygons; }
+
 	/**
 	 * @brief Update nest availability status across all polygons
 	 * @details Loops through all landscape elements and updates their Osmia nesting
@@ -959,11 +1203,13 @@ public:
 	 * Called periodically during simulation to reflect dynamic habitat changes.
 	 *
 	 * @par Implementation
-	 * Delegates to OsmiaPolygonEntry::UpdateOsmiaNesting() for each polygon.
+	 * Delegates to OsmiaPolygonEntry::UpdateOsmiaNesting() for each nest-capable polygon.
+	 * Polygons with no nest capacity are not visited, so the daily cost scales with
+	 * nesting habitat rather than with the whole landscape.
 	 */
 	void UpdateOsmiaNesting() {
-		for (unsigned int s = 0; s < m_PolyList.size(); s++) {
-			m_PolyList[s].UpdateOsmiaNesting();
+		for (unsigned int s = 0; s < m_NestCapablePolygons.size(); s++) {
+			m_PolyList[m_NestCapablePolygons[s]].UpdateOsmiaNesting();
 		}
 	}
 
@@ -983,9 +1229,63 @@ public:
 	 */
 	bool IsOsmiaNestPossible(int a_polyindex)
 	{
+		if (IsPolygonFull(a_polyindex)) return false;
 		return m_PolyList[a_polyindex].IsOsmiaNestPossible();
 	}
 
+	/**
+	 * @brief true if a polygon is known to have no free nest capacity
+	 * @param a_polyindex Polygon index
+	 *
+	 * @details Reads the shared full-polygon bitmap without taking the polygon lock, so many
+	 * searching females can skip full polygons cheaply. InitPolygonNesting() sets it once at
+	 * start-up for polygons with no capacity. After that it is set when a new nest brings the count
+	 * to m_MaxNests and cleared when ReleaseOsmiaNest() frees a place, both under the polygon lock,
+	 * so it follows the nest count exactly. A reader racing with a change may see the state just
+	 * before it, as it would have with the lock.
+	 *
+	 * @par Why not cache failed probability tests
+	 * The nesting probability is drawn afresh on each attempt, so one female's failed draw says
+	 * nothing about the next female's and is not cached.
+	 */
+	bool IsPolygonFull(int a_polyindex) const
+	{
+		uint64_t word = m_FullPolygons[a_polyindex >> 6].load(std::memory_order_relaxed);
+		return (word >> (a_polyindex & 63)) & 1;
+	}
+
+	/**
+	 * @brief Build the run-length cell lists of polygons whose type can hold nests
+	 * @details Scans the landscape raster once, row by row in parallel, and stores each eligible
+	 * polygon's cells as horizontal runs with the number of cells before each run (a compressed
+	 * sparse row layout). Called at the end of InitOsmiaBeeNesting().
+	 */
+	void BuildPolygonCellIndex();
+
+	/**
+	 * @brief Uniform random location inside a polygon
+	 * @param a_polyindex Polygon index
+	 * @return A landscape cell of the polygon, every cell equally likely
+	 * @details Draws one random cell number and binary-searches the polygon's runs, so the cost
+	 * is O(log runs) whatever the polygon's shape. Polygons without a cell list (types that could
+	 * not hold nests at startup) fall back to Landscape::SupplyARandomLocPoly(). Thread-safe.
+	 */
+	APoint SupplyRandomLocation(int a_polyindex) const;
+
+	/** @brief Number of raster cells in a polygon's cell list (0 if it has none) */
+	unsigned GetPolygonCells(int a_polyindex) const {
+		if (m_CellRunStart.empty()) return 0;
+		return m_PolygonCells[a_polyindex];
+	}
+
+	/**
+	 * @brief Choose the microclimate class of a new nest
+	 * @param a_nest The nest, with its aspect delay already set
+	 * @param a_polyindex Polygon containing the nest
+	 * @return Class index, aspect band (0 warm, 1 neutral, 2 cool) + 3 if the habitat is shaded
+	 */
+	uint8_t ClassifyMicroclimate(Osmia_Nest* a_nest, int a_polyindex);
+
 	/**
 	 * @brief Create new nest at specified location
 	 * @param a_x Landscape X-coordinate (meters)
@@ -993,8 +1293,8 @@ public:
 	 * @param a_polyindex Polygon containing nest
 	 * @return Pointer to newly created Osmia_Nest object
 	 *
-	 * @details Creates Osmia_Nest object and increments polygon's nest count.
-	 * Called by Osmia_Female when suitable cavity found during nest-finding.
+	 * @details Creates Osmia_Nest object, assigns its microclimate class and increments
+	 * polygon's nest count. Called by Osmia_Female when suitable cavity found during nest-finding.
 	 *
 	 * @par Thread Safety
 	 * Caller (Osmia_Population_Manager::CreateNest) manages polygon lock.
@@ -1004,7 +1304,9 @@ public:
 	Osmia_Nest* CreateNest(int a_x, int a_y, int a_polyindex)
 	{
 		Osmia_Nest* a_nest = new Osmia_Nest(a_x, a_y, a_polyindex, this);
+		a_nest->SetMicroclimateClass(ClassifyMicroclimate(a_nest, a_polyindex));
 		m_PolyList[a_polyindex].IncOsmiaNesting(a_nest);
+		if (!m_PolyList[a_polyindex].HasNestCapacity()) SetPolygonFull(a_polyindex, true);
 		return a_nest;
 	}
 
@@ -1035,6 +1337,7 @@ public:
 	{
 		omp_set_nest_lock(m_PolyListLocks[a_polyindex]);
 		m_PolyList[a_polyindex].ReleaseOsmiaNest(a_nest);
+		if (m_PolyList[a_polyindex].HasNestCapacity()) SetPolygonFull(a_polyindex, false);
 		omp_unset_nest_lock(m_PolyListLocks[a_polyindex]);
 	}
 
@@ -1085,7 +1388,48 @@ public:
 		return true;
 	}
 
+	/**
+	 * @brief Size the per-thread cell death queues
+	 * @param a_threads Number of threads that may call QueueCellDeath()
+	 * @details Must be called from serial code. Called from Osmia_Population_Manager::Init().
+	 */
+	void ResetCellDeathQueues(int a_threads) {
+		m_CellDeathQueues.resize(a_threads > 0 ? unsigned(a_threads) : 1);
+	}
+
+	/**
+	 * @brief Queue the occupant of a nest cell for death
+	 * @param a_nest Nest containing the cell
+	 * @param a_slot Slot index of the cell
+	 * @details Called by Osmia_Nest::KillAllSubsequentCells() after it updates the mask. Each
+	 * thread appends to its own queue, so no further locking is needed.
+	 */
+	void QueueCellDeath(Osmia_Nest* a_nest, int a_slot) {
+		unsigned thread = omp_in_parallel() ? unsigned(omp_get_thread_num()) : 0;
+		if (thread >= m_CellDeathQueues.size()) {
+#pragma omp critical (OsmiaCellDeathQueue)
+			m_CellDeathQueues[0].push_back(make_pair(a_nest, a_slot));
+		}
+		else m_CellDeathQueues[thread].push_back(make_pair(a_nest, a_slot));
+	}
+
+	/**
+	 * @brief Kill all queued cell occupants
+	 * @details Called from serial code at the start of Osmia_Population_Manager::DoLast().
+	 * The occupant of each queued slot is read at this point, so an individual that changed
+	 * life stage after being queued is still found. Occupants already dead are skipped.
+	 */
+	void ProcessCellDeaths();
+
 protected:
+	/** @brief Set or clear a polygon's bit in the full-polygon bitmap (atomic) */
+	void SetPolygonFull(int a_polyindex, bool a_full)
+	{
+		uint64_t bit = uint64_t(1) << (a_polyindex & 63);
+		if (a_full) m_FullPolygons[a_polyindex >> 6].fetch_or(bit, std::memory_order_relaxed);
+		else m_FullPolygons[a_polyindex >> 6].fetch_and(~bit, std::memory_order_relaxed);
+	}
+
 	/**
 	 * @brief List of polygon entries tracking nest availability
 	 * @details One entry per landscape polygon, stores nest capacity and current count.
@@ -1093,6 +1437,13 @@ protected:
 	 */
 	vector<OsmiaPolygonEntry> m_PolyList;
 
+	/**
+	 * @brief Per-thread queues of (nest, slot) cells whose occupants must die
+	 * @details Filled by QueueCellDeath() during the parallel step and emptied by
+	 * ProcessCellDeaths().
+	 */
+	vector<vector<pair<Osmia_Nest*, int>>> m_CellDeathQueues;
+
 	/**
 	 * @brief Polygon-level locks for thread safety
 	 * @details OpenMP nest locks enabling concurrent nest operations across different
@@ -1107,8 +1458,852 @@ protected:
 	 * configuration files.
 	 */
 	bool m_PossibleNestType[tole_Foobar];
+
+	/** @brief Maximum nests per hectare for each landscape element type (from the nests file) */
+	double m_NestDensityByType[tole_Foobar];
+
+	/** @brief Nesting probability for each landscape element type (from the nests file) */
+	double m_NestProbByType[tole_Foobar];
+
+	/** @brief True once the per-type tables have been filled (from file or bundle) */
+	bool m_NestTypeTablesSet = false;
+
+	/**
+	 * @brief Polygons whose maximum nest count is above zero
+	 * @details Ascending polygon index, filled by InitPolygonNesting().
+	 */
+	vector<int> m_NestCapablePolygons;
+
+	/**
+	 * @brief One bit per polygon, set while the polygon has no free nest capacity
+	 * @details std::atomic rather than OpenMP atomics, since the lock-free read needs OpenMP 3.1
+	 * and MSVC /openmp is OpenMP 2.0. Relaxed order is enough: the bit is only a hint, and a
+	 * female that finds a free polygon still takes its lock to create the nest.
+	 */
+	vector<std::atomic<uint64_t>> m_FullPolygons;
+
+	/** @brief One horizontal run of raster cells belonging to a polygon */
+	struct CellRun {
+		int m_x;               ///< First cell of the run
+		int m_y;               ///< Row of the run
+		unsigned m_before;     ///< Cells of the polygon in earlier runs
+	};
+
+	/** @brief First run of each polygon in m_CellRuns, plus a final end entry */
+	vector<unsigned> m_CellRunStart;
+
+	/** @brief Runs of all indexed polygons, grouped by polygon, rows top to bottom */
+	vector<CellRun> m_CellRuns;
+
+	/** @brief Total cells per polygon (0 if not indexed) */
+	vector<unsigned> m_PolygonCells;
+};
+
+//==============================================================================
+// ATOMIC FILE REPLACEMENT
+//==============================================================================
+
+/**
+ * @brief Write a file so that readers only ever see the old or the new contents
+ * @param a_filename File to create or replace
+ * @param a_writer Writes the contents to the stream it is given
+ * @param a_binary Open the temporary file in binary mode
+ * @return true if the file was written and renamed into place
+ * @details The contents go to a temporary file in the same directory, named from a_filename,
+ * the process id and a per-process counter, so concurrent runs of a batch and threads of one
+ * run never share a temporary file. The temporary file then replaces a_filename in a single
+ * rename, which overwrites the target atomically, so the target is never missing. On failure
+ * the temporary file is removed and a_filename is left as it was.
+ */
+bool OsmiaWriteFileAtomically(const string& a_filename, const std::function<void(ostream&)>& a_writer, bool a_binary = true);
+
+//==============================================================================
+// BINARY PARAMETER BUNDLE
+//==============================================================================
+
+/**
+ * @class OsmiaParameterBundle
+ * @brief Compiled binary copy of the raw parameter tables and the derived lookup tables
+ * 
+ * @details Startup otherwise parses the nests-by-habitat file and many CfgArray_Double
+ * entries as text, then rebuilds the sex ratio, cocoon mass, provisioning and forage
+ * efficiency tables with exp/pow loops. The bundle stores all of these as one flat
+ * block of doubles so a batch of runs can load them with a single read.
+ * 
+ * @par File Layout
+ * A fixed-size Header followed by the payload. The header holds a magic number, the
+ * schema version, a fingerprint of the text inputs, a checksum of the payload, and the
+ * offset and length (in doubles) of each section. Sections are contiguous. Load() checks
+ * the section table against the file length before reading, so a truncated or corrupt
+ * bundle is rejected rather than allocated from. Byte order and
+ * double format are those of the machine that wrote it; the fingerprint includes
+ * sizeof(double) and tole_Foobar so that a bundle from an incompatible build is rejected.
+ * 
+ * @par Source of Truth
+ * The text inputs remain authoritative. A bundle is used only if its fingerprint matches
+ * the current inputs and its checksum is valid; otherwise the tables are rebuilt from
+ * text and the bundle is rewritten.
+ * 
+ * @see Osmia_Population_Manager::ComputeParameterFingerprint()
+ */
+class OsmiaParameterBundle
+{
+public:
+	/** @brief Sections stored in the bundle, in payload order */
+	enum TTypeOfOsmiaBundleSection : unsigned {
+		obs_NestDensityByType = 0,  ///< Max nests per ha by landscape element type
+		obs_NestProbByType,         ///< Nesting probability by landscape element type
+		obs_PNThresholds,           ///< Monthly pollen/nectar thresholds, 4 per month
+		obs_PrePupalDevelRates,     ///< Prepupal development rate by integer temperature
+		obs_EggSexRatio,            ///< Sex ratio table, mass class major, age minor
+		obs_FemaleCocoonMass,       ///< Provision mass table, mass class major, age minor
+		obs_NestProvisioning,       ///< Cell construction hours by female age
+		obs_ForageEfficiency,       ///< Foraging efficiency by female age
+		obs_foobar                  ///< Number of sections
+	};
+
+	/** @brief Magic number "OSPB" */
+	static const uint32_t m_Magic = 0x4250534F;
+
+	/** @brief Schema version; increment whenever sections or their meaning change */
+	static const uint32_t m_SchemaVersion = 2;
+
+	/** @brief Fixed-size file header */
+	struct Header {
+		uint32_t m_magic;
+		uint32_t m_schema;
+		uint64_t m_fingerprint;
+		uint64_t m_checksum;
+		uint32_t m_noageclasses;
+		uint32_t m_reserved;
+		uint64_t m_offset[obs_foobar];
+		uint64_t m_length[obs_foobar];
+	};
+
+	/** @brief Number of age classes per mass class in the two 2-D tables */
+	unsigned m_NoAgeClasses = 0;
+
+	/**
+	 * @brief Store one section
+	 * @param a_section Section identifier
+	 * @param a_data Values to store (copied)
+	 * @details Sections may be set in any order; the payload is assembled by Save().
+	 */
+	void SetSection(TTypeOfOsmiaBundleSection a_section, const vector<double>& a_data) { m_Sections[a_section] = a_data; }
+
+	/** @brief Get one section as loaded or set */
+	const vector<double>& GetSection(TTypeOfOsmiaBundleSection a_section) const { return m_Sections[a_section]; }
+
+	/**
+	 * @brief Read and validate a bundle
+	 * @param a_filename Bundle file
+	 * @param a_fingerprint Fingerprint of the current text inputs
+	 * @return true if the file exists, is intact and matches a_fingerprint
+	 */
+	bool Load(const string& a_filename, uint64_t a_fingerprint);
+
+	/**
+	 * @brief Write the bundle
+	 * @param a_filename Bundle file
+	 * @param a_fingerprint Fingerprint of the text inputs the tables were built from
+	 * @return true on success
+	 * @details Written with OsmiaWriteFileAtomically(), so a concurrent reader in another
+	 * run of the batch never sees a partly written bundle.
+	 */
+	bool Save(const string& a_filename, uint64_t a_fingerprint) const;
+
+	/**
+	 * @brief 64-bit FNV-1a hash
+	 * @param a_data Bytes to hash
+	 * @param a_size Number of bytes
+	 * @param a_hash Hash to continue from (the FNV offset basis to start a new one)
+	 * @return Updated hash
+	 */
+	static uint64_t Hash(const void* a_data, size_t a_size, uint64_t a_hash = 14695981039346656037ULL);
+
+protected:
+	/** @brief Section contents */
+	vector<double> m_Sections[obs_foobar];
 };
 
+#ifdef __OSMIATESTING
+//==============================================================================
+// STATISTICAL EQUIVALENCE HARNESS (Testing builds only)
+//==============================================================================
+
+/**
+ * @class OsmiaEquivalenceHarness
+ * @brief Records output distributions per run and tests two engines for statistical equivalence
+ * 
+ * @details Optimised execution paths (batched mortality, structure-of-arrays brood, macro-steps,
+ * quantised state) consume random numbers in a different order from the reference object
+ * model, so their output cannot be compared bit for bit. Instead each run records the raw
+ * samples of a set of summary metrics. Runs over N seeds with the reference engine are then
+ * compared with N seeds of the candidate engine, metric by metric, using two-sample
+ * Kolmogorov-Smirnov and Anderson-Darling tests.
+ * 
+ * @par Workflow
+ * 1. Run the reference engine N times with OSMIA_EQUIV_ENGINE = "reference" and a distinct
+ *    OSMIA_EQUIV_OUTPUT file per seed.
+ * 2. Do the same with the candidate engine.
+ * 3. Set OSMIA_EQUIV_REFERENCE and OSMIA_EQUIV_CANDIDATE to the two space-separated file lists
+ *    and OSMIA_EQUIV_REPORT to a report name, on the last run or on a short run of either
+ *    engine. The report is written when the population manager is destroyed.
+ * 
+ * @par Tests
+ * Samples of each metric are pooled over seeds. The Kolmogorov-Smirnov p-value uses the
+ * asymptotic distribution with the Stephens small-sample correction. Anderson-Darling uses
+ * the Scholz and Stephens (1987) two-sample statistic, corrected for ties because stage
+ * durations and dates are integers. It is standardised and compared with their critical values.
+ * A metric passes if neither test rejects at the Bonferroni-corrected level
+ * alpha / number of metrics. The run passes if every metric passes.
+ */
+class OsmiaEquivalenceHarness
+{
+public:
+	/** @brief Metrics recorded per run */
+	enum TTypeOfOsmiaEquivalenceMetric : unsigned {
+		oem_EggStageLength = 0,     ///< Days in egg stage
+		oem_LarvalStageLength,      ///< Days in larval stage
+		oem_PrePupalStageLength,    ///< Days in prepupal stage
+		oem_PupalStageLength,       ///< Days in pupal stage
+		oem_InCocoonStageLength,    ///< Days in cocoon (including overwintering)
+		oem_EmergenceDay,           ///< Day in year of each female emergence
+		oem_FemaleMass,             ///< Mass of each emerging female (mg)
+		oem_YearlyNests,            ///< Nests created per simulated year
+		oem_YearlyPopulation,       ///< Live individuals (all stages) at year end
+		oem_foobar                  ///< Number of metrics
+	};
+
+	/** @brief Result of comparing one metric */
+	struct MetricResult {
+		double m_KS_D;          ///< Kolmogorov-Smirnov statistic
+		double m_KS_p;          ///< Kolmogorov-Smirnov p-value
+		double m_AD_T;          ///< Standardised Anderson-Darling statistic
+		double m_AD_critical;   ///< Critical value of m_AD_T at the corrected alpha
+		bool m_pass;            ///< Neither test rejects
+	};
+
+	/**
+	 * @brief Add one sample (thread-safe)
+	 * @param a_metric Metric identifier
+	 * @param a_value Sample value
+	 */
+	void AddSample(TTypeOfOsmiaEquivalenceMetric a_metric, double a_value) {
+#pragma omp critical (OsmiaEquivalenceSample)
+		m_Samples[a_metric].push_back(a_value);
+	}
+
+	/**
+	 * @brief Write this run's samples
+	 * @param a_filename Output file
+	 * @param a_engine Engine tag recorded in the file header
+	 */
+	void Write(const string& a_filename, const string& a_engine) const;
+
+	/**
+	 * @brief Read and pool samples from a list of run files
+	 * @param a_filenames Space-separated file names
+	 * @return false if any file is missing or malformed
+	 */
+	bool Read(const string& a_filenames);
+
+	/**
+	 * @brief Compare reference and candidate runs and write a pass/fail report
+	 * @param a_reference Pooled reference samples
+	 * @param a_candidate Pooled candidate samples
+	 * @param a_alpha Family-wise significance level
+	 * @param a_report Report stream
+	 * @return true if every metric passes
+	 */
+	static bool Compare(const OsmiaEquivalenceHarness& a_reference, const OsmiaEquivalenceHarness& a_candidate, double a_alpha, ostream& a_report);
+
+	/** @brief Short name of a metric, used in files and reports */
+	static const char* MetricName(unsigned a_metric);
+
+	/**
+	 * @brief Two-sample Kolmogorov-Smirnov test
+	 * @param a_x First sample (sorted)
+	 * @param a_y Second sample (sorted)
+	 * @param a_D [out] Maximum distance between the empirical distribution functions
+	 * @return Asymptotic p-value
+	 */
+	static double KolmogorovSmirnov(const vector<double>& a_x, const vector<double>& a_y, double& a_D);
+
+	/**
+	 * @brief Two-sample Anderson-Darling test, tie-corrected (Scholz and Stephens 1987)
+	 * @param a_x First sample (sorted)
+	 * @param a_y Second sample (sorted)
+	 * @return Standardised statistic, approximately zero-mean unit-variance under the null
+	 */
+	static double AndersonDarling(const vector<double>& a_x, const vector<double>& a_y);
+
+	/**
+	 * @brief Critical value of the standardised two-sample Anderson-Darling statistic
+	 * @param a_alpha Significance level
+	 * @return Value interpolated in log(alpha) from the Scholz and Stephens table for k = 2
+	 */
+	static double AndersonDarlingCritical(double a_alpha);
+
+protected:
+	/** @brief Raw samples, one vector per metric */
+	vector<double> m_Samples[oem_foobar];
+};
+#endif // __OSMIATESTING
+
+//==============================================================================
+// COMPACT BINARY ENCODING (shared by the binary output formats)
+//==============================================================================
+
+/** @brief Append an unsigned variable-length integer (7 bits per byte, low bits first) */
+inline void OsmiaPutVarint(vector<uint8_t>& a_bytes, uint64_t a_value) {
+	while (a_value >= 0x80) {
+		a_bytes.push_back(uint8_t(a_value) | 0x80);
+		a_value >>= 7;
+	}
+	a_bytes.push_back(uint8_t(a_value));
+}
+
+/** @brief Read an unsigned variable-length integer; returns false at the end of the buffer */
+inline bool OsmiaGetVarint(const uint8_t*& a_pos, const uint8_t* a_end, uint64_t& a_value) {
+	a_value = 0;
+	for (int shift = 0; a_pos < a_end && shift < 64; shift += 7) {
+		uint8_t b = *a_pos++;
+		a_value |= uint64_t(b & 0x7F) << shift;
+		if (!(b & 0x80)) return true;
+	}
+	return false;
+}
+
+/** @brief Map a signed value to unsigned so small magnitudes of either sign encode short */
+inline uint64_t OsmiaZigZag(int64_t a_value) { return (uint64_t(a_value) << 1) ^ uint64_t(a_value >> 63); }
+
+/** @brief Inverse of OsmiaZigZag() */
+inline int64_t OsmiaUnZigZag(uint64_t a_value) { return int64_t(a_value >> 1) ^ -int64_t(a_value & 1); }
+
+//==============================================================================
+// SPATIAL OUTPUT RASTERS
+//==============================================================================
+
+/**
+ * @class OsmiaRasterOutput
+ * @brief Counts of nests, brood, females and parasitoids binned onto a regular grid
+ * 
+ * @details Gives landscape maps of the population without writing per-agent text. The grid
+ * cell size is OSMIA_RASTER_CELLSIZE metres. Layers are kept up to date in different ways:
+ * - **Nests and brood stages** are counted incrementally: +1 when a nest is created or an
+ *   individual enters a stage, -1 when the nest is released or the individual leaves the stage
+ *   (transition, death or emergence). Brood never moves, so no rescan is ever needed.
+ *   Updates are atomic because they happen inside the parallel step.
+ * - **Females** come from the female density grid, which the females already maintain
+ *   incrementally as they emerge, move and die. The layer holds the density of the 1 km cell
+ *   containing each raster cell centre, in females per km2, rather than a count per raster cell.
+ *   A count would be the density times the cell area, which rounds to zero for any sensible
+ *   cell size and density.
+ * - **Parasitoids** are sampled from the parasitoid grid at each raster cell centre and stored
+ *   as parasitoids per km2 (summed over parasitoid types), for the same reason.
+ * 
+ * So the nest and brood layers are counts per raster cell and the female and parasitoid layers
+ * are densities per km2. File version 2 marks this; version 1 files held area-scaled counts.
+ * 
+ * @par File format
+ * Every OSMIA_RASTER_INTERVAL days a snapshot `<prefix>_<day>.orst` is written. The file holds
+ * a FileHeader, then one uint64 offset per tile (layer by layer, tile rows top to bottom) plus a
+ * final end offset, then the tile data the offsets point into. A tile covers
+ * m_TileSize × m_TileSize cells in row-major order and is run-length encoded as
+ * (run length, zig-zag value) varint pairs. Maps are mostly zero, so tiles shrink to a few
+ * bytes and any tile can be decoded alone (a chunked-array layout). The origin is the
+ * landscape's (0,0) corner with y increasing downwards, as in the ALMaSS landscape raster.
+ */
+class OsmiaRasterOutput
+{
+public:
+	/** @brief Output layers */
+	enum TTypeOfOsmiaRasterLayer : unsigned {
+		orl_Egg = 0,       ///< Indexed as TTypeOfOsmiaLifeStages for the brood stages
+		orl_Larva,
+		orl_Prepupa,
+		orl_Pupa,
+		orl_InCocoon,
+		orl_Female,
+		orl_Nest,
+		orl_Parasitoid,
+		orl_foobar
+	};
+
+	/** @brief Fixed file header */
+	struct FileHeader {
+		uint64_t m_magic;
+		uint32_t m_version;
+		uint32_t m_day;
+		uint32_t m_width;      ///< Cells
+		uint32_t m_height;     ///< Cells
+		uint32_t m_cellsize;   ///< Metres
+		uint32_t m_tilesize;   ///< Cells per tile side
+		uint32_t m_layers;
+		uint32_t m_reserved;
+	};
+
+	/** @brief Allocate the layers for a landscape of the given size (metres); a_cellsize 0 disables */
+	void Init(int a_landscapewidth, int a_landscapeheight, int a_cellsize);
+
+	/** @brief true if output is enabled */
+	bool IsOn() const { return m_CellSize > 0; }
+
+	/** @brief Add a_delta to the cell containing landscape point (a_x, a_y); thread-safe */
+	void Add(unsigned a_layer, int a_x, int a_y, int a_delta) {
+		int cell = (a_x / m_CellSize) + (a_y / m_CellSize) * m_Width;
+#pragma omp atomic
+		m_Layers[a_layer][cell] += a_delta;
+	}
+
+	/** @brief Set a cell of a sampled density layer (females, parasitoids) before writing */
+	void SetCell(unsigned a_layer, int a_cx, int a_cy, int a_value) { m_Layers[a_layer][a_cx + a_cy * m_Width] = a_value; }
+
+	/** @brief Grid width in cells */
+	int GetWidth() const { return m_Width; }
+	/** @brief Grid height in cells */
+	int GetHeight() const { return m_Height; }
+	/** @brief Cell size in metres */
+	int GetCellSize() const { return m_CellSize; }
+
+	/** @brief Write a snapshot file (temporary name, then renamed). Returns false on failure. */
+	bool Write(const string& a_filename, unsigned a_day) const;
+
+	/** @brief Tile side in cells */
+	static const int m_TileSize = 64;
+	/** @brief File magic number ("OSMRAST1") */
+	static const uint64_t m_Magic = 0x315453415252534FULL;
+
+protected:
+	/** @brief Run-length encode one tile of one layer */
+	void EncodeTile(unsigned a_layer, int a_tx, int a_ty, vector<uint8_t>& a_bytes) const;
+
+	/** @brief Cell counts per layer, row-major */
+	vector<int> m_Layers[orl_foobar];
+	/** @brief Grid width in cells */
+	int m_Width = 0;
+	/** @brief Grid height in cells */
+	int m_Height = 0;
+	/** @brief Cell size in metres (0 = output disabled) */
+	int m_CellSize = 0;
+};
+
+//==============================================================================
+// STREAMING CLIMATE INPUT
+//==============================================================================
+
+#if defined(__unix__) || defined(__APPLE__)
+/** @brief Defined where the climate stream can memory-map its file (otherwise it reads windows) */
+#define OSMIA_CLIMATE_MMAP 1
+#endif
+
+/**
+ * @class OsmiaClimateStream
+ * @brief Daily climate read from a binary file a window at a time, for very long runs
+ * 
+ * @details The Osmia phenology triggers need only today's mean temperature, today's flying
+ * hours and the mean temperatures of the last few days (the pre-wintering rule in
+ * Osmia_Population_Manager::DoLast() looks back five days). For 80-100 year climate projections
+ * this class supplies those values from a compact binary file instead of the landscape weather.
+ * 
+ * @par Memory
+ * Only a window of m_WindowDays records is mapped (or, without mmap, read into a buffer) at a
+ * time, and the window is moved forward as the simulation advances. The rolling temperature
+ * history is a ring of m_HistoryDays values. Memory use is therefore fixed, whatever the run
+ * length.
+ * 
+ * @par Day numbering
+ * Record k of the file is simulation day k, counted as g_date->OldDays() + g_date->DayInYear().
+ * Record 0 must therefore be 1 January of the first simulated year, i.e. the first row of the
+ * converted text file. Unlike the landscape weather the file does not wrap: a projection that
+ * silently went back to its first year would be wrong, so a day past the last record is an
+ * error (see HasDay()). History days before day 0 repeat record 0.
+ * 
+ * @par File format
+ * A FileHeader followed by one DayRecord per day, in date order, in host byte order. Files are
+ * made from the ALMaSS weather text files by Convert(). For hourly input the hourly values are
+ * kept, so the flying hours thresholds can be changed without reconverting. Daily input has no
+ * diurnal course to count flying hours from, so such files supply temperature only (HasHours()
+ * is false) and flying hours stay with the landscape weather.
+ */
+class OsmiaClimateStream
+{
+public:
+	/** @brief Hours per day record */
+	static const int m_HoursPerDay = 24;
+	/** @brief Days of mean temperature history kept (today and the days before) */
+	static const int m_HistoryDays = 8;
+	/** @brief File magic number ("OSMCLIM1") */
+	static const uint64_t m_Magic = 0x314D494C434D534FULL;
+	/** @brief File format version */
+	static const uint32_t m_Version = 2;
+
+	/** @brief Fixed file header */
+	struct FileHeader {
+		uint64_t m_magic;
+		uint32_t m_version;
+		uint32_t m_nodays;      ///< Number of day records
+		uint32_t m_recordsize;  ///< sizeof(DayRecord), checked on opening
+		uint32_t m_hourly;      ///< 1 if converted from hourly input, so the hourly values are real
+	};
+
+	/** @brief One day of climate (hourly values are zero in files made from daily input) */
+	struct DayRecord {
+		float m_meantemp;                ///< Daily mean temperature (°C)
+		float m_temp[m_HoursPerDay];     ///< Hourly temperature (°C)
+		float m_wind[m_HoursPerDay];     ///< Hourly wind speed (m/s)
+		float m_rain[m_HoursPerDay];     ///< Hourly precipitation (mm)
+	};
+
+	~OsmiaClimateStream() { Close(); }
+
+	/**
+	 * @brief Open a converted climate file
+	 * @param a_filename Binary file written by Convert()
+	 * @param a_windowdays Number of day records held in memory at once
+	 * @return false if the file is missing, empty or not a climate stream of this version
+	 */
+	bool Open(const string& a_filename, unsigned a_windowdays);
+
+	/** @brief Release the file and any mapped window */
+	void Close();
+
+	/** @brief true if a climate file is open */
+	bool IsOpen() const { return m_Header.m_nodays > 0; }
+
+	/** @brief true if the open file has a record for simulation day a_day */
+	bool HasDay(long a_day) const { return a_day >= 0 && a_day < long(m_Header.m_nodays); }
+
+	/** @brief true if the open file holds hourly values, so it can supply flying hours */
+	bool HasHours() const { return m_Header.m_hourly != 0; }
+
+	/** @brief Set the hourly conditions under which females can fly */
+	void SetFlyingThresholds(double a_mintemp, double a_maxwind, double a_maxrain) {
+		m_MinFlyingTemp = a_mintemp;
+		m_MaxFlyingWind = a_maxwind;
+		m_MaxFlyingRain = a_maxrain;
+	}
+
+	/**
+	 * @brief Make a_day today: update the temperature history and, if HasHours(), today's flying hours
+	 * @param a_day Absolute simulation day (g_date->OldDays() + g_date->DayInYear())
+	 * @return false if a_day is past the last record (HasDay() is false) or could not be read
+	 * @details Consecutive days cost one record read. After a jump (including the first call)
+	 * the whole history is refilled from the file.
+	 */
+	bool Advance(long a_day);
+
+	/** @brief Mean temperature a_daysago days before today (0 = today, up to m_HistoryDays - 1) */
+	double GetTemp(int a_daysago = 0) const { return m_History[Slot(m_Today - a_daysago)]; }
+
+	/** @brief Hours today meeting all the flying thresholds (only meaningful if HasHours()) */
+	int GetFlyingHours() const { return m_FlyingHours; }
+
+	/**
+	 * @brief Convert an ALMaSS weather text file to a climate stream file
+	 * @param a_textfile Whitespace-separated rows of year month day temperature wind rain (daily)
+	 * or year month day hour temperature wind rain (hourly). Rows with fewer numbers than the
+	 * format needs, such as the record count line, are skipped; extra columns are ignored.
+	 * @param a_binfile Output file, written under a temporary name and then renamed
+	 * @param a_hourly Format of a_textfile, as set by OSMIA_CLIMATE_STREAM_SOURCE_HOURLY
+	 * @return false if the input cannot be read or holds no days, or the output cannot be written
+	 * @details Hourly rows for the same date make up one record, and the daily mean is the mean of
+	 * the hours given. A daily row only gives the mean temperature; its hourly values are left at
+	 * zero and the file is marked as not holding hours.
+	 */
+	static bool Convert(const string& a_textfile, const string& a_binfile, bool a_hourly);
+
+protected:
+	/** @brief Ring slot of an absolute day in m_History */
+	static int Slot(long a_day) { return int(((a_day % m_HistoryDays) + m_HistoryDays) % m_HistoryDays); }
+
+	/** @brief Record for an absolute day, moving the window if needed (NULL if outside the file or on read failure) */
+	const DayRecord* Fetch(long a_day);
+
+	FileHeader m_Header = FileHeader();
+	/** @brief Records held in one window */
+	unsigned m_WindowDays = 0;
+	/** @brief Index of the first record in the current window */
+	uint64_t m_WindowFirst = 0;
+	/** @brief Number of records in the current window (0 = none loaded) */
+	uint64_t m_WindowCount = 0;
+	/** @brief First record of the current window */
+	const DayRecord* m_Window = NULL;
+#ifdef OSMIA_CLIMATE_MMAP
+	/** @brief File descriptor of the open file */
+	int m_Fd = -1;
+	/** @brief Start of the mapped region (page aligned, may begin before m_Window) */
+	char* m_Map = NULL;
+	/** @brief Length of the mapped region */
+	size_t m_MapLength = 0;
+#else
+	/** @brief The open file */
+	ifstream m_File;
+	/** @brief Records of the current window */
+	vector<DayRecord> m_Buffer;
+#endif
+	/** @brief Mean temperature ring, indexed by Slot(day) */
+	double m_History[m_HistoryDays] = {};
+	/** @brief Absolute day last passed to Advance() */
+	long m_Today = -1;
+	/** @brief true once Advance() has succeeded */
+	bool m_Started = false;
+	/** @brief Today's flying hours */
+	int m_FlyingHours = 0;
+	double m_MinFlyingTemp = 6.0;
+	double m_MaxFlyingWind = 8.0;
+	double m_MaxFlyingRain = 0.1;
+};
+
+#ifdef __OSMIA_LINEAGE
+//==============================================================================
+// LINEAGE RECORDING (Compiled only with __OSMIA_LINEAGE)
+//==============================================================================
+
+/**
+ * @class OsmiaLineageLog
+ * @brief Compact append-only record of every egg laid: mother, nest, provision mass and sex
+ * 
+ * @details Used for fitness and pedigree analysis. Each individual gets a 64-bit identifier when
+ * laid (or at initialisation for the founding cocoons), and it is carried unchanged through the
+ * life stages into the adult female. Each egg produces one record linking it to its mother.
+ * 
+ * @par Storage
+ * Writing a text line per egg from inside the parallel step would serialise the threads on
+ * the stream. Instead each thread appends records to its own byte segment, with no locking.
+ * Fields are variable-length integers (7 bits per byte) and identifiers are delta-encoded
+ * against the previous record in the segment, so a typical record takes 10-14 bytes. At the
+ * end of each day (Osmia_Population_Manager::DoLast(), serial) each non-empty segment is written
+ * as a block, and an index entry (file offset, day, identifier range) is kept in memory. Close()
+ * appends the index and a trailer, so OsmiaLineageReader can find blocks without scanning.
+ * 
+ * @par File layout
+ * FileHeader, then per block a BlockHeader followed by its encoded records, then an IndexEntry
+ * per block, then the Trailer. All fixed-width fields are in host byte order.
+ * 
+ * @par Record encoding (varints, delta state reset at each block)
+ * id - previous id | id - mother id (0 if mother unknown) | x | y | polygon | nest slot + 1 |
+ * provision mass in 0.01 mg | flags (bit 0 sex, bits 1+ parasitoid status)
+ */
+class OsmiaLineageLog
+{
+public:
+	/** @brief One decoded lineage record */
+	struct Record {
+		uint64_t m_id = 0;           ///< Identifier of the new individual
+		uint64_t m_mother = 0;       ///< Identifier of its mother (0 = founder or unknown)
+		unsigned m_day = 0;          ///< Simulation day the egg was laid
+		int m_x = 0;                 ///< Nest x-coordinate
+		int m_y = 0;                 ///< Nest y-coordinate
+		int m_polyref = 0;           ///< Nest polygon
+		int m_nestslot = -1;         ///< Cell slot in the nest, in laying order
+		double m_mass = 0.0;         ///< Provision mass (mg, rounded to 0.01)
+		bool m_sex = false;          ///< true = female
+		unsigned m_parasitised = 0;  ///< TTypeOfOsmiaParasitoids value at laying
+	};
+
+	/** @brief Fixed file header */
+	struct FileHeader {
+		uint64_t m_magic;
+		uint32_t m_version;
+		uint32_t m_reserved;
+	};
+
+	/** @brief Header preceding each block of records */
+	struct BlockHeader {
+		uint32_t m_day;
+		uint32_t m_thread;
+		uint32_t m_count;   ///< Records in the block
+		uint32_t m_bytes;   ///< Encoded length of the records
+	};
+
+	/** @brief Index entry locating one block */
+	struct IndexEntry {
+		uint64_t m_offset;  ///< File offset of the BlockHeader
+		uint64_t m_firstid;
+		uint64_t m_lastid;
+		uint32_t m_day;
+		uint32_t m_count;
+	};
+
+	/** @brief Trailer at the end of a closed file */
+	struct Trailer {
+		uint64_t m_indexoffset;
+		uint64_t m_entries;
+		uint64_t m_magic;
+	};
+
+	/**
+	 * @brief Open the output file and create one segment per thread
+	 * @return false if the file cannot be created (recording then stays off)
+	 */
+	bool Open(const string& a_filename, int a_threads);
+
+	/** @brief true if recording is on */
+	bool IsOpen() const { return m_Open; }
+
+	/** @brief Get a new, unique, increasing identifier (thread-safe) */
+	uint64_t NewID() { return ++m_NextID; }
+
+	/** @brief Append a record to the calling thread's segment (no locking) */
+	void Append(const Record& a_record);
+
+	/** @brief Write all non-empty segments as blocks and clear them. Call from serial code. */
+	void Flush();
+
+	/** @brief Flush, then write the index and trailer and close the file */
+	void Close();
+
+	/** @brief File and trailer magic numbers */
+	static const uint64_t m_FileMagic = 0x314E494C4D534FULL;   // "OSMLIN1"
+	static const uint64_t m_IndexMagic = 0x58444E494C4D534FULL; // "OSMLINDX"
+
+protected:
+	/** @brief Records buffered by one thread since the last flush */
+	struct Segment {
+		vector<uint8_t> m_bytes;
+		uint64_t m_firstid = 0;
+		uint64_t m_lastid = 0;
+		unsigned m_day = 0;
+		unsigned m_count = 0;
+	};
+	/** @brief One segment per thread, written only by its owner during the step */
+	vector<Segment> m_Segments;
+	/** @brief Index of the blocks written so far */
+	vector<IndexEntry> m_Index;
+	/** @brief Output stream */
+	ofstream m_File;
+	/** @brief Last identifier issued */
+	std::atomic<uint64_t> m_NextID{ 0 };
+	/** @brief Recording on */
+	bool m_Open = false;
+};
+
+/**
+ * @class OsmiaLineageReader
+ * @brief Indexed reader for files written by OsmiaLineageLog
+ * 
+ * @details Open() reads only the header, trailer and index. Blocks are decoded on demand, so
+ * lookups by day or by individual read just the blocks whose range can contain the answer.
+ */
+class OsmiaLineageReader
+{
+public:
+	/** @brief Open a closed lineage file and load its index; false if missing, unclosed or corrupt */
+	bool Open(const string& a_filename);
+	/** @brief Number of blocks in the file */
+	size_t GetBlockCount() const { return m_Index.size(); }
+	/** @brief Decode one block, appending its records */
+	bool ReadBlock(size_t a_block, vector<OsmiaLineageLog::Record>& a_records);
+	/** @brief All records laid between two simulation days (inclusive) */
+	bool ReadDays(unsigned a_firstday, unsigned a_lastday, vector<OsmiaLineageLog::Record>& a_records);
+	/** @brief Find the record of one individual, reading only blocks whose identifier range contains it */
+	bool FindIndividual(uint64_t a_id, OsmiaLineageLog::Record& a_record);
+	/**
+	 * @brief All offspring of one mother
+	 * @details Offspring have larger identifiers than their mother, so blocks whose identifiers
+	 * all precede the mother are skipped.
+	 */
+	bool FindOffspring(uint64_t a_mother, vector<OsmiaLineageLog::Record>& a_records);
+protected:
+	/** @brief Input stream */
+	ifstream m_File;
+	/** @brief Block index loaded from the end of the file */
+	vector<OsmiaLineageLog::IndexEntry> m_Index;
+};
+#endif // __OSMIA_LINEAGE
+
+#ifdef __OSMIA_METRICS
+//==============================================================================
+// LIVE METRICS EXPORT (Compiled only with __OSMIA_METRICS)
+//==============================================================================
+
+/**
+ * @class OsmiaMetricsExporter
+ * @brief Publishes run-time progress of a running simulation as a Prometheus text file
+ * 
+ * @details Long batch runs give no sign of progress until they finish. With __OSMIA_METRICS
+ * defined, the population manager times its daily phases and writes a snapshot at
+ * the end of each day (or every OSMIA_METRICS_INTERVAL days). The snapshot holds the
+ * simulated day, per-stage counts and memory, per-phase wall-clock time, agents per
+ * second, nest lock wait time and the number of brood transitions that took the nest lock.
+ * It is written in the Prometheus text exposition format.
+ * 
+ * @par Why a file rather than an endpoint
+ * The batch machines run many replicates side by side with no spare ports and no HTTP
+ * library in the build. So the snapshot is written to a file named by OSMIA_METRICS_FILE:
+ * first to a temporary name, then renamed, so a reader never sees a partial file. The
+ * node_exporter textfile collector, or a plain `cat`, picks it up without disturbing the run.
+ * 
+ * @par Cost
+ * Nothing is compiled in without __OSMIA_METRICS. With it defined but no file configured,
+ * the cost is three clock reads per day.
+ */
+class OsmiaMetricsExporter
+{
+public:
+	/** @brief Daily phases timed by the population manager */
+	enum TTypeOfOsmiaMetricsPhase : unsigned {
+		omph_DoFirst = 0,   ///< Daily global updates
+		omph_Agents,        ///< All agent BeginStep/Step/EndStep passes (DoFirst end to DoLast start)
+		omph_DoLast,        ///< End-of-day updates and merges
+		omph_foobar
+	};
+
+	/** @brief Per-stage values gathered by the population manager for one snapshot */
+	struct StageSnapshot {
+		const char* m_name;     ///< Stage label
+		unsigned m_count;       ///< Live individuals
+		double m_bytes;         ///< Estimated memory held by the stage list and its objects
+	};
+
+	/** @brief Set the output file and publishing interval in days ("" disables output) */
+	void SetOutput(const string& a_filename, int a_interval) {
+		m_Filename = a_filename;
+		m_Interval = (a_interval < 1) ? 1 : a_interval;
+	}
+
+	/** @brief Mark the start of a phase */
+	void StartPhase(TTypeOfOsmiaMetricsPhase a_phase) { m_PhaseStart[a_phase] = std::chrono::steady_clock::now(); }
+
+	/** @brief Mark the end of a phase and accumulate its duration */
+	void EndPhase(TTypeOfOsmiaMetricsPhase a_phase) {
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_PhaseStart[a_phase]).count();
+		m_PhaseSeconds[a_phase] = secs;
+		m_PhaseTotalSeconds[a_phase] += secs;
+	}
+
+	/** @brief true if a snapshot is due today */
+	bool IsDue(long a_day) const { return !m_Filename.empty() && (a_day % m_Interval == 0); }
+
+	/**
+	 * @brief Write a snapshot
+	 * @param a_day Simulated day number since the start of the run
+	 * @param a_year Simulated year
+	 * @param a_stages Per-stage values
+	 * @param a_lockwaitsecs Cumulative time threads have spent waiting for nest locks
+	 * @param a_lockedtransfers Cumulative brood transitions that took the nest lock
+	 * 
+	 * @details Writes through OsmiaWriteFileAtomically(). Write failures are ignored:
+	 * monitoring must never stop a run.
+	 */
+	void Write(long a_day, int a_year, const vector<StageSnapshot>& a_stages, double a_lockwaitsecs, unsigned long a_lockedtransfers) const;
+
+protected:
+	/** @brief Output file name; empty disables publishing */
+	string m_Filename;
+	/** @brief Publish every m_Interval days */
+	int m_Interval = 1;
+	/** @brief Start time of each phase today */
+	std::chrono::steady_clock::time_point m_PhaseStart[omph_foobar];
+	/** @brief Duration of each phase today (seconds) */
+	double m_PhaseSeconds[omph_foobar] = { 0.0, 0.0, 0.0 };
+	/** @brief Cumulative duration of each phase since the start of the run (seconds) */
+	double m_PhaseTotalSeconds[omph_foobar] = { 0.0, 0.0, 0.0 };
+};
+#endif // __OSMIA_METRICS
+
 //==============================================================================
 // MAIN POPULATION MANAGER CLASS
 //==============================================================================
@@ -1241,6 +2436,25 @@ public:
 	bool IsOsmiaNestPossible(int a_polyindex) {
 		return m_OurOsmiaNestManager.IsOsmiaNestPossible(a_polyindex);
 	}
+
+	/**
+	 * @brief Lock-free test for a polygon with no free nest capacity
+	 * @details Lets nest searching skip full polygons before any locked test. See
+	 * Osmia_Nest_Manager::IsPolygonFull().
+	 */
+	bool IsNestPolygonFull(int a_polyindex) const {
+		return m_OurOsmiaNestManager.IsPolygonFull(a_polyindex);
+	}
+
+	/**
+	 * @brief Uniform random location inside a polygon, for placing founders and nest searching
+	 * @param a_polyindex Polygon index
+	 * @details Uses the nest manager's run-length cell lists (see
+	 * Osmia_Nest_Manager::SupplyRandomLocation()). Thread-safe.
+	 */
+	APoint SupplyRandomLocation(int a_polyindex) const {
+		return m_OurOsmiaNestManager.SupplyRandomLocation(a_polyindex);
+	}
 	
 	/**
 	 * @brief Create new nest at specified location
@@ -1274,6 +2488,11 @@ public:
 		m_TheLandscape->SetPolygonLock(a_polyindex);
 		return_nest_ptr = m_OurOsmiaNestManager.CreateNest(a_x, a_y, a_polyindex); 
 		m_TheLandscape->ReleasePolygonLock(a_polyindex);
+		RasterAdd(OsmiaRasterOutput::orl_Nest, a_x, a_y, 1);
+#ifdef __OSMIATESTING
+#pragma omp atomic
+		m_NestsCreatedThisYear++;
+#endif
 		return return_nest_ptr;	
 	}
 	
@@ -1299,11 +2518,12 @@ public:
 	 * @see CreateNest() for nest creation
 	 */
 	void ReleaseOsmiaNest(int a_polyindex, Osmia_Nest* a_nest) {
+		RasterAdd(OsmiaRasterOutput::orl_Nest, a_nest->GetX(), a_nest->GetY(), -1);
 		m_TheLandscape->SetPolygonLock(a_polyindex);
 		m_OurOsmiaNestManager.ReleaseOsmiaNest(a_polyindex, a_nest);
 		m_TheLandscape->ReleasePolygonLock(a_polyindex);
 	}
-	
+
 	/**
 	 * @brief Query daily foraging hours available
 	 * @return Number of hours suitable for *Osmia* flight today
@@ -1360,7 +2580,8 @@ public:
 	 * @par Implementation Note
 	 * Lookup table populated during Init() for ages 0-364 days. Bees rarely survive
 	 * beyond 60 days, so upper range provides safety margin without significant memory
-	 * cost (365 × 8 bytes = ~3 KB per population manager).
+	 * cost (365 × 8 bytes = ~3 KB per population manager). Ages outside 0-364 are clamped
+	 * to the nearest end of the table.
 	 */
 	double GetProvisioningParams(int a_age) {
 		return m_NestProvisioningParameters[a_age];
@@ -1632,6 +2853,57 @@ public:
 	void WriteNestTestData(OsmiaNestData a_target, OsmiaNestData a_achieved);
 #endif // __OSMIATESTING
 
+public:
+	/**
+	 * @brief Change the count of a stage or nests at a location in the spatial output rasters
+	 * @param a_layer Raster layer (brood stages use their TTypeOfOsmiaLifeStages value)
+	 * @param a_x Landscape x-coordinate
+	 * @param a_y Landscape y-coordinate
+	 * @param a_delta +1 on entry, -1 on exit
+	 * @details No-op unless OSMIA_RASTER_INTERVAL is set. Thread-safe.
+	 */
+	void RasterAdd(unsigned a_layer, int a_x, int a_y, int a_delta) {
+		if (m_Raster.IsOn()) m_Raster.Add(a_layer, a_x, a_y, a_delta);
+	}
+
+protected:
+	/** @brief Spatial output rasters */
+	OsmiaRasterOutput m_Raster;
+
+	/** @brief Streaming climate input (open only if OSMIA_CLIMATE_STREAM_FILE is set) */
+	OsmiaClimateStream m_Climate;
+
+	/**
+	 * @brief Mean temperature a_daysago days before a_day
+	 * @details From the climate stream's history if one is open, otherwise from the landscape.
+	 * The stream holds OsmiaClimateStream::m_HistoryDays days, so a_daysago must be below that.
+	 */
+	double SupplyDailyTemp(int a_day, int a_daysago) {
+		if (m_Climate.IsOpen()) return m_Climate.GetTemp(a_daysago);
+		return m_TheLandscape->SupplyTempPeriod(a_day - a_daysago, 1);
+	}
+
+	/** @brief Fill the sampled raster layers and write a snapshot if one is due today */
+	void WriteRasters();
+
+#ifdef __OSMIA_LINEAGE
+protected:
+	/** @brief Mother-offspring log, open when OSMIA_RECORD_LINEAGE is set */
+	OsmiaLineageLog m_Lineage;
+
+	/** @brief Append the lineage record for a new egg or founding cocoon (a_mother = 0 for founders) */
+	void RecordLineage(Osmia_Base* a_new, struct_Osmia* a_data, uint64_t a_mother);
+#endif // __OSMIA_LINEAGE
+
+#ifdef __OSMIA_METRICS
+protected:
+	/** @brief Phase timer and snapshot writer for the live metrics export */
+	OsmiaMetricsExporter m_Metrics;
+
+	/** @brief Gather stage counts, memory estimates and lock wait, and write a metrics snapshot */
+	void PublishMetrics();
+#endif // __OSMIA_METRICS
+
 protected:
 	//==========================================================================
 	// PROTECTED ATTRIBUTES
@@ -1670,6 +2942,12 @@ protected:
 	
 	/** @brief Statistics accumulator for in-cocoon stage durations */
 	SimpleStatistics m_InCocoonStageLength;
+
+	/** @brief Raw samples for the statistical equivalence harness */
+	OsmiaEquivalenceHarness m_Equivalence;
+
+	/** @brief Nests created since the last year-end record (for the equivalence harness) */
+	int m_NestsCreatedThisYear = 0;
 #endif
 	
 	/** 
@@ -1680,6 +2958,14 @@ protected:
 	 * data combined with floral resource models.
 	 */
 	PollenMap_centroidbased* m_ThePollenMap;
+
+	/**
+	 * @brief Pointer to the mechanistic parasitoid population manager
+	 * @details Same object as Osmia_Base::m_OurParasitoidPopulationManager, held here so
+	 * the manager can report daily host activity. May be NULL if no parasitoid manager
+	 * is registered with the landscape.
+	 */
+	OsmiaParasitoid_Population_Manager* m_OurParasitoidPopulationManager;
 	
 	/** 
 	 * @brief Daily foraging hours available (weather-dependent)
@@ -1762,7 +3048,7 @@ protected:
 	 * 
 	 * @see GetProvisioningParams() for access method
 	 */
-	double m_NestProvisioningParameters[365];
+	OsmiaAgeTable m_NestProvisioningParameters;
 	
 	/** 
 	 * @brief Logistic equations for egg sex ratio vs. age/mass [96 mass classes × 365 ages]
@@ -1846,9 +3132,11 @@ protected:
 	 * Although prepupal model is time-based (not degree-day), rates still weakly
 	 * temperature-dependent to acknowledge physiological reality.
 	 * 
+	 * Indexed by temperature rounded to whole degrees; reads clamp to 0-41 °C.
+	 * 
 	 * @see GetPrePupalDevelDays() for daily rate access
 	 */
-	vector<double> m_PrePupalDevelRates;
+	OsmiaTemperatureTable m_PrePupalDevelRates;
 	
 	/** 
 	 * @brief Today's prepupal development rate (pre-calculated)
@@ -1856,6 +3144,13 @@ protected:
 	 * Cached for efficiency (all prepupae query same value throughout day).
 	 */
 	double m_PrePupalDevelDaysToday;
+
+	/**
+	 * @brief Live count of each stage on each day of the year (0-365), most recent year
+	 * @details Filled by ReserveStageCapacity() each morning. Entries for days not yet reached
+	 * this year still hold last year's counts, which are used to predict list capacity.
+	 */
+	vector<unsigned> m_StageCountHistory[6];
 	
 	/** 
 	 * @brief Monthly pollen and nectar quality/quantity thresholds
@@ -1869,6 +3164,39 @@ protected:
 	 * @see OsmiaPollenNectarThresholds class documentation
 	 */
 	vector<OsmiaPollenNectarThresholds> m_PN_thresholds;
+
+	//==========================================================================
+	// PARAMETER TABLES (Text inputs or binary bundle)
+	//==========================================================================
+
+	/**
+	 * @brief Build the derived lookup tables from the text configuration
+	 * @details Fills m_PN_thresholds, m_PrePupalDevelRates, m_EggSexRatioEqns,
+	 * m_FemaleCocoonMassEqns, m_NestProvisioningParameters and the female forage
+	 * efficiency table. This is the reference path; the bundle only caches its output.
+	 * @par Bulk build
+	 * The age-dependent logistic denominators are evaluated once per age and shared by
+	 * every mass class, and the mass classes are then filled in parallel. The mass values
+	 * are still accumulated serially, so the tables are bit-identical to a serial build
+	 * and the bundle fingerprint stays valid.
+	 */
+	void BuildParameterTables();
+
+	/**
+	 * @brief Fingerprint of every text input used by BuildParameterTables() and the nests file
+	 * @return FNV-1a hash over the schema version, build characteristics, configuration values
+	 * and the raw bytes of the nests-by-habitat file
+	 */
+	uint64_t ComputeParameterFingerprint();
+
+	/** @brief Copy the built tables (and nest type tables) into a bundle */
+	void CaptureParameterBundle(OsmiaParameterBundle& a_bundle);
+
+	/**
+	 * @brief Fill the tables from a loaded bundle
+	 * @return false if a section has an unexpected length (the caller then rebuilds from text)
+	 */
+	bool ApplyParameterBundle(const OsmiaParameterBundle& a_bundle);
 	
 	//==========================================================================
 	// SCHEDULING METHODS (ALMaSS Framework Hooks)
@@ -1888,6 +3216,14 @@ protected:
 	 * scheduler before individual agents execute BeginStep().
 	 */
 	virtual void DoFirst();
+
+	/**
+	 * @brief Grow stage lists ahead of predicted seasonal peaks
+	 * @details Called at the start of DoFirst(). Predicts each stage's count over the coming
+	 * days from last year's daily counts and, for eggs, from current female egg loads, then
+	 * reserves list capacity so the lists are not reallocated during the step.
+	 */
+	void ReserveStageCapacity();
 	
 	/** 
 	 * @brief Pre-step updates executed before Step but after DoFirst
@@ -1917,6 +3253,11 @@ protected:
 	 * 
 	 * @details Critical seasonal logic and statistics:
 	 * 
+	 * **Parasitoid Merge**:
+	 * - Apply parasitoid changes buffered by bees during the parallel step
+	 *   (OsmiaParasitoid_Population_Manager::MergeThreadBuffers())
+	 * - Kill nest cells queued by emerging bombylids (Osmia_Nest_Manager::ProcessCellDeaths())
+	 * 
 	 * **Seasonal Flag Management**:
 	 * - Check for pre-wintering end (sustained autumn temperature drop)
 	 * - Set overwintering end flag (March 1st)
@@ -1943,18 +3284,29 @@ protected:
 	 * @see m_PreWinteringEndFlag, m_OverWinterEndFlag
 	 */
 	virtual void DoLast() {
+#ifdef __OSMIA_METRICS
+		m_Metrics.EndPhase(OsmiaMetricsExporter::omph_Agents);
+		m_Metrics.StartPhase(OsmiaMetricsExporter::omph_DoLast);
+#endif
+		// Parasitoid additions from emerging bees are buffered per thread during the step
+		if (m_OurParasitoidPopulationManager != NULL) m_OurParasitoidPopulationManager->MergeThreadBuffers();
+		// Cells killed by emerging bombylids are processed in one batch
+		m_OurOsmiaNestManager.ProcessCellDeaths();
+#ifdef __OSMIA_LINEAGE
+		if (m_Lineage.IsOpen()) m_Lineage.Flush();
+#endif
 		int today = m_TheLandscape->SupplyDayInYear();
 		if (today > September) {
 			int day = g_date->OldDays() + g_date->DayInYear();
-			double t0 = m_TheLandscape->SupplyTempPeriod(day, 1);
+			double t0 = SupplyDailyTemp(day, 0);
 			
 			// Check for end of pre-wintering phase
 			if (!m_PreWinteringEndFlag) {
-				double t1 = m_TheLandscape->SupplyTempPeriod(day - 1, 1);
-				double t2 = m_TheLandscape->SupplyTempPeriod(day - 2, 1);
-				double t3 = m_TheLandscape->SupplyTempPeriod(day - 3, 1);
-				double t4 = m_TheLandscape->SupplyTempPeriod(day - 4, 1);
-				double t5 = m_TheLandscape->SupplyTempPeriod(day - 5, 1);
+				double t1 = SupplyDailyTemp(day, 1);
+				double t2 = SupplyDailyTemp(day, 2);
+				double t3 = SupplyDailyTemp(day, 3);
+				double t4 = SupplyDailyTemp(day, 4);
+				double t5 = SupplyDailyTemp(day, 5);
 				
 				// Sustained autumn cooling pattern
 				if (((t2 < 13.0) && (t1 < 13.0) && (t0 < 13.0)) && 
@@ -2004,7 +3356,19 @@ protected:
 			m_PupaStageLength.ClearData();
 			m_InCocoonStageLength.ClearData();
 			file1.close();
+
+			// Year-end samples for the equivalence harness
+			int live = 0;
+			for (int st = 0; st <= int(TTypeOfOsmiaLifeStages::to_OsmiaFemale); st++) live += SupplyListSize(st);
+			m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_YearlyPopulation, live);
+			m_Equivalence.AddSample(OsmiaEquivalenceHarness::oem_YearlyNests, m_NestsCreatedThisYear);
+			m_NestsCreatedThisYear = 0;
 		}
+#endif
+		if (m_Raster.IsOn()) WriteRasters();
+#ifdef __OSMIA_METRICS
+		m_Metrics.EndPhase(OsmiaMetricsExporter::omph_DoLast);
+		PublishMetrics();
 #endif
 	}
 };
@@ -68,6 +68,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 #include <forward_list>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#ifdef __OSMIA_METRICS
+#include <chrono>
+#endif
 
 class Osmia_Population_Manager;
 class OsmiaParasitoid_Population_Manager;
@@ -78,6 +86,7 @@ class Osmia_Egg;
 class Osmia_Female;
 class struct_Osmia;
 class Osmia_Base;
+enum class TTypeOfOsmiaLifeStages : int;
 
 //------------------------------------------------------------------------------
 /**
@@ -86,6 +95,206 @@ class Osmia_Base;
 //typedef vector<Osmia*> TListOfOsmia;
 //---------------------------------------------------------------------------
 
+/**
+ * @def OSMIA_OMP_SIMD
+ * @brief Defined when the compiler's OpenMP has the simd construct (OpenMP 4.0 or later)
+ * @details MSVC /openmp implements OpenMP 2.0, which rejects "omp simd", so the pragma is
+ * only given when this is defined. Without it the loops are left to the auto-vectoriser.
+ */
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#define OSMIA_OMP_SIMD
+#endif
+
+/**
+ * @class OsmiaLookupTable
+ * @brief Fixed-size, cache-aligned table of a curve sampled at integer positions
+ * @tparam N Number of entries (positions 0 to N-1)
+ *
+ * @details Used for the small derived curves read in the agent hot paths: foraging efficiency
+ * and provisioning time by female age, and prepupal development rate by temperature. Replaces
+ * raw arrays and vectors indexed without checks.
+ *
+ * @par Clamping
+ * Every read clamps its position into [0, N-1], so an old female, a longer configured lifespan
+ * or an extreme temperature reads the end value instead of memory past the table. The clamp is
+ * a min/max pair that compiles to conditional moves, so there is no branch in the lookup.
+ *
+ * @par Filling
+ * Fill() copies up to N values and repeats the last one to the end of the table, so a curve
+ * computed over a shorter range (e.g. an older parameter bundle) still gives a full table.
+ *
+ * @par Bulk Access
+ * Gather() and GatherInterpolated() read a whole array of positions at once, for passes over
+ * structure-of-arrays female data. Each element is independent, so the loops vectorise.
+ */
+template <size_t N>
+class OsmiaLookupTable
+{
+	static_assert(N >= 2, "OsmiaLookupTable needs at least two entries to interpolate");
+public:
+	OsmiaLookupTable() { std::fill(m_Values, m_Values + N, 0.0); }
+
+	/** @brief Number of entries */
+	static constexpr size_t Size() { return N; }
+
+	/** @brief Clamp a position into the table range without branching */
+	static size_t Clamp(int a_index) { return size_t(std::min(std::max(a_index, 0), int(N) - 1)); }
+
+	/** @brief Copy up to N values, repeating the last to the end of the table */
+	void Fill(const double* a_values, size_t a_n)
+	{
+		size_t n = std::min(a_n, N);
+		std::copy(a_values, a_values + n, m_Values);
+		std::fill(m_Values + n, m_Values + N, n > 0 ? m_Values[n - 1] : 0.0);
+	}
+
+	/** @brief Set one entry; positions outside the table are ignored */
+	void Set(int a_index, double a_value) { if (a_index >= 0 && a_index < int(N)) m_Values[a_index] = a_value; }
+
+	/** @brief Value at a position, clamped into the table */
+	double operator[](int a_index) const { return m_Values[Clamp(a_index)]; }
+
+	/**
+	 * @brief Linearly interpolated value at a fractional position, clamped into the table
+	 * @details At integer positions this returns exactly the stored value.
+	 */
+	double Interpolate(double a_x) const
+	{
+		double x = std::min(std::max(a_x, 0.0), double(N - 1));
+		size_t i = std::min(size_t(x), N - 2);
+		double f = x - double(i);
+		return m_Values[i] + f * (m_Values[i + 1] - m_Values[i]);
+	}
+
+	/** @brief Clamped lookup of a_n positions into a_out */
+	void Gather(const int* a_index, double* a_out, size_t a_n) const
+	{
+#ifdef OSMIA_OMP_SIMD
+		#pragma omp simd
+#endif
+		for (size_t i = 0; i < a_n; i++) a_out[i] = m_Values[Clamp(a_index[i])];
+	}
+
+	/** @brief Clamped, interpolated lookup of a_n fractional positions into a_out */
+	void GatherInterpolated(const double* a_x, double* a_out, size_t a_n) const
+	{
+#ifdef OSMIA_OMP_SIMD
+		#pragma omp simd
+#endif
+		for (size_t i = 0; i < a_n; i++) a_out[i] = Interpolate(a_x[i]);
+	}
+
+	/** @brief The raw entries, e.g. for writing to the parameter bundle */
+	const double* Data() const { return m_Values; }
+
+protected:
+	/** @brief Entries, aligned to a cache line so the smaller tables sit in one or two lines */
+	alignas(64) double m_Values[N];
+};
+
+/** @brief Curve indexed by adult age in days (foraging efficiency, provisioning time) */
+typedef OsmiaLookupTable<365> OsmiaAgeTable;
+
+/** @brief Curve indexed by whole degrees Celsius from 0 to 41 (prepupal development rate) */
+typedef OsmiaLookupTable<42> OsmiaTemperatureTable;
+
+/**
+ * @def OSMIA_MAX_SPECIES
+ * @brief Maximum number of solitary bee species simulated together
+ * @details Species 0 is always *O. bicornis*, parameterised from the usual configuration
+ * entries. Further species are read from OSMIA_SPECIES_FILE.
+ */
+#define OSMIA_MAX_SPECIES 4
+
+/**
+ * @struct OsmiaSpeciesTraits
+ * @brief Life-history constants of one solitary bee species
+ * @details Every individual carries a species index (Osmia_Base::m_Species) and reads its
+ * development, mortality and mass constants through Osmia_Base::Traits(). Several species can
+ * therefore share one population manager, one daily pass over the stage lists, one environment
+ * snapshot, one pollen map and one parasitoid grid. Only these constants differ between them.
+ * 
+ * @par File format
+ * OSMIA_SPECIES_FILE holds one species per line: a name without spaces followed by any number
+ * of key=value pairs, where the key is a member name without its m_ prefix (e.g.
+ * EggDevelThreshold=9.0). Keys that are not given keep the *O. bicornis* value. Lines starting
+ * with # are comments. The InitialFraction values of the added species must not sum to more
+ * than 1.
+ */
+struct OsmiaSpeciesTraits
+{
+	string m_Name = "Osmia_bicornis";              ///< Species name, used in output
+	double m_EggDevelThreshold = 0.0;              ///< Egg lower developmental threshold (°C)
+	double m_EggDevelTotalDD = 0.0;                ///< Egg degree-days to hatch
+	double m_LarvaDevelThreshold = 0.0;            ///< Larva lower developmental threshold (°C)
+	double m_LarvaDevelTotalDD = 0.0;              ///< Larva degree-days to prepupation
+	double m_PrepupaDevelTotalDays = 0.0;          ///< Mean prepupal duration (days)
+	double m_PupaDevelThreshold = 0.0;             ///< Pupa lower developmental threshold (°C)
+	double m_PupaDevelTotalDD = 0.0;               ///< Pupa degree-days to eclosion
+	double m_InCocoonOverwinteringTempThreshold = 0.0;  ///< Overwintering degree-day threshold (°C)
+	double m_InCocoonEmergenceTempThreshold = 0.0;      ///< Minimum temperature for emergence (°C)
+	double m_InCocoonPrewinteringTempThreshold = 0.0;   ///< Pre-wintering degree-day threshold (°C)
+	double m_InCocoonEmergCountConst = 0.0;        ///< Emergence counter intercept (days)
+	double m_InCocoonEmergCountSlope = 0.0;        ///< Emergence counter slope (days per degree-day)
+	double m_InCocoonWinterMortConst = 0.0;        ///< Winter mortality intercept (%)
+	double m_InCocoonWinterMortSlope = 0.0;        ///< Winter mortality slope (% per pre-wintering degree-day)
+	double m_EggDailyMort = 0.0;                   ///< Egg daily mortality probability
+	double m_LarvaDailyMort = 0.0;                 ///< Larva daily mortality probability
+	double m_PrepupaDailyMort = 0.0;               ///< Prepupa daily mortality probability
+	double m_PupaDailyMort = 0.0;                  ///< Pupa daily mortality probability
+	double m_FemaleMassFromProvMassConst = 0.0;    ///< Adult female mass from provision mass, intercept (mg)
+	double m_FemaleMassFromProvMassSlope = 0.0;    ///< Adult female mass from provision mass, slope
+	double m_FemaleMinMass = 0.0;                  ///< Minimum adult female mass (mg)
+	double m_FemaleMaxMass = 0.0;                  ///< Maximum adult female mass (mg)
+	double m_TypicalHomingDistance = 0.0;          ///< Foraging range within which half of trips end (m)
+	double m_MaxHomingDistance = 0.0;              ///< Foraging range within which 90% of trips end (m)
+	double m_InitialFraction = 0.0;                ///< Share of the founding population (species 0 takes the rest)
+};
+
+/**
+ * @def OSMIA_MICROCLIMATE_CLASSES
+ * @brief Number of nest microclimate classes
+ * @details Three aspect bands (warm, neutral, cool) for each of open and shaded habitat. A nest's
+ * class is aspect + 3 × shaded (see Osmia_Nest_Manager::ClassifyMicroclimate()).
+ */
+#define OSMIA_MICROCLIMATE_CLASSES 6
+
+/**
+ * @struct OsmiaDailyEnvironment
+ * @brief Snapshot of the global conditions for one simulated day
+ * @details Built once by Osmia_Population_Manager::DoFirst() and then read-only for the rest of
+ * the day. The stage development kernels take it by const reference, so no agent calls back into
+ * the Landscape or the population manager for state that is the same for every individual.
+ *
+ * @par Phenology Flags
+ * The pre-wintering and over-wintering flags are updated in DoLast(), so the values copied here
+ * are the ones that held throughout the agents' step, exactly as the per-agent queries returned.
+ *
+ * @par Microclimate
+ * Nest temperature differs from the landscape temperature by a fixed offset per microclimate
+ * class. The manager computes each class's temperature and each stage's daily development
+ * increment once, and brood index these arrays by the class cached from their nest. With the
+ * microclimate layer switched off every class holds the landscape values. The degree-day
+ * increments also depend on the stage thresholds, so they are held per species.
+ */
+struct OsmiaDailyEnvironment
+{
+	double m_Temp = -9999;            ///< Mean daily temperature (°C)
+	int m_TempInt = -9999;            ///< Temperature rounded to the nearest whole degree
+	int m_DayInYear = 0;              ///< Day of the year (0-364)
+	int m_Month = 0;                  ///< Month of the year (1-12)
+	int m_FlyingHours = 0;            ///< Hours of weather suitable for flying
+	double m_PrePupalDevelDays = 0.0; ///< Prepupal development increment for today's temperature
+	bool m_PreWinteringEnded = false; ///< Autumn cooling has ended pre-wintering
+	bool m_OverWinterEnded = false;   ///< March 1st reached, spring emergence may proceed
+	bool m_Microclimate = false;      ///< Nest microclimate classes are on, so aspect acts through m_ClassTemp
+	double m_ClassTemp[OSMIA_MICROCLIMATE_CLASSES] = {};         ///< Nest temperature by microclimate class (°C)
+	double m_ClassEggDD[OSMIA_MAX_SPECIES][OSMIA_MICROCLIMATE_CLASSES] = {};    ///< Egg degree-days gained today by species and class
+	double m_ClassLarvaDD[OSMIA_MAX_SPECIES][OSMIA_MICROCLIMATE_CLASSES] = {};  ///< Larva degree-days gained today by species and class
+	double m_ClassPrePupaDays[OSMIA_MICROCLIMATE_CLASSES] = {};                 ///< Prepupal development increment by class
+	double m_ClassPupaDD[OSMIA_MAX_SPECIES][OSMIA_MICROCLIMATE_CLASSES] = {};   ///< Pupa degree-days gained today by species and class
+};
+
 /**
  * @def __OSMIA_DIST_SIZE
  * @brief Size of pre-calculated distribution arrays for movement probabilities
@@ -160,8 +369,12 @@ static CfgFloat cfg_OsmiaTotalCocoonMassLossRange("OSMIATOTALCOCOONMASSLOSSRANGE
  * @par State Transition Logic
  * Most states follow the pattern: perform behaviour → check conditions → return next state or toOsmias_Die.
  * The population manager calls Step() repeatedly until all agents return a terminal state.
+ * 
+ * @par Storage
+ * Stored as one byte per individual (uint8_t underlying type), since there are millions of
+ * brood individuals and only eight states.
  */
-enum TTypeOfOsmiaState
+enum TTypeOfOsmiaState : uint8_t
 {
 	/** @brief Initial state upon object creation; performs setup and transitions to first active state */
 	toOsmias_InitialState = 0,
@@ -337,6 +550,59 @@ public:
 	OsmiaForageMaskDetailed(int a_step, int a_maxdistance);
 };
 
+/**
+ * @class OsmiaForageMaskCatalogue
+ * @brief Body-size foraging range classes over the shared detailed mask
+ *
+ * @details Foraging range scales with body size, so a single mask built for the typical homing
+ * distance over-reaches for small females and under-reaches for large ones. Rather than store a
+ * mask per female, Configure() rebuilds the shared OsmiaForageMaskDetailed with its offsets sorted
+ * by distance from the centre, out to the largest class range. The mask of any class is then a
+ * prefix of that vector, and the catalogue only stores where each prefix ends.
+ *
+ * @par Range Classes
+ * Class ranges are spaced evenly between the smallest and largest range configured. A female
+ * maps her own range (see Osmia_Female::GetForageRange()) to the nearest class. With one class
+ * the detailed mask is left as constructed and the whole of it is used, as before.
+ *
+ * @par Thread Safety
+ * Configured once, serially, in Osmia_Population_Manager::Init() and read-only from then on.
+ */
+class OsmiaForageMaskCatalogue
+{
+public:
+	/**
+	 * @brief Set the class ranges and sort the detailed mask to match them
+	 * @param a_noclasses Number of range classes (at least one)
+	 * @param a_minrange Range of the smallest class (m)
+	 * @param a_maxrange Range of the largest class (m)
+	 * @param a_mask The shared detailed mask; rebuilt out to a_maxrange when there are several classes
+	 */
+	void Configure(int a_noclasses, double a_minrange, double a_maxrange, OsmiaForageMaskDetailed& a_mask);
+
+	/** @brief Range class whose range is nearest to a_range */
+	int GetRangeClass(double a_range) const;
+
+	/** @brief Number of range classes */
+	int GetNoClasses() const { return int(m_ClassRange.size()); }
+
+	/** @brief Foraging range of a class (m) */
+	double GetClassRange(int a_class) const { return m_ClassRange[a_class]; }
+
+	/**
+	 * @brief Number of leading detailed mask offsets within the range of a_class
+	 * @details The offsets are in order of increasing distance, so a search of a_class reads
+	 * m_mask[0] to m_mask[GetMaskSize(a_class) - 1] and can stop as soon as it has found enough.
+	 */
+	size_t GetMaskSize(int a_class) const { return m_ClassEnd[a_class]; }
+
+protected:
+	/** @brief Range of each class (m), ascending */
+	vector<double> m_ClassRange;
+	/** @brief Number of leading mask offsets within each class range */
+	vector<size_t> m_ClassEnd;
+};
+
 /**
  * @class OsmiaNestData
  * @brief Data structure recording nest contents and provisioning status
@@ -387,9 +653,12 @@ public:
  * simultaneously in parallelised simulations. All nest modifications must acquire the lock first.
  * 
  * @par Implementation Note
- * The cells are stored as a forward_list rather than vector because cells are only added (never 
- * removed or accessed by index), and forward_list provides efficient insertion with minimal memory
- * overhead.
+ * Cells are stored in laying order in a vector, so each cell has a fixed slot index (0 = first cell
+ * laid, at the back of the cavity). Each occupant carries its slot index (Osmia_Base::m_NestSlot),
+ * which makes pointer replacement during metamorphosis O(1). A 64-bit mask records which slots still
+ * hold a living individual. Killing every cell laid after a given slot is a single mask operation,
+ * and the affected individuals are queued on the Osmia_Nest_Manager. They are killed in one batch at
+ * the end of the step, not inline from a sibling's Step().
  */
 class Osmia_Nest : public TAnimal
 {
@@ -415,12 +684,25 @@ protected:
 	int m_PolyRef;
 	
 	/** 
-	 * @brief Forward-linked list of pointers to Osmia_Egg objects contained in nest cells
+	 * @brief Current occupant of each nest cell, indexed by slot in laying order
 	 * @details Each element represents one provisioned cell with its egg or developing larva.
-	 * Cells are added to the front of the list as the female provisions them sequentially.
-	 * This maintains temporal order (newest cells at front).
+	 * Cells are appended as the female provisions them, so slot 0 is the oldest cell. The
+	 * pointer is updated whenever the occupant changes life stage. Entries are never removed;
+	 * whether a cell is still occupied is recorded in m_alive.
+	 */
+	vector<TAnimal*> m_cells;
+
+	/**
+	 * @brief Bit mask of cells holding a living individual (bit n = slot n)
+	 * @details Set when a cell is added, cleared when its occupant dies or emerges. Only the first
+	 * m_MaxTrackedCells slots are tracked; any later cells are stored but never killed by
+	 * KillAllSubsequentCells(). The configured maximum eggs per nest is well below this.
+	 * Written under the cell lock; std::atomic so that IsCellAlive() can read it without one.
 	 */
-	std::forward_list<TAnimal*>m_cells;
+	std::atomic<uint64_t> m_alive{ 0 };
+
+	/** @brief Number of slots that can be represented in m_alive */
+	static const int m_MaxTrackedCells = 64;
 	
 	/** 
 	 * @brief OpenMP nested lock for thread-safe nest access
@@ -441,8 +723,9 @@ protected:
 	 * @brief Flag indicating whether nest is open for adding new cells
 	 * @details Set to false when nest is sealed (female completes provisioning or dies). Prevents
 	 * addition of new cells to abandoned nests. True whilst active female is provisioning.
+	 * Atomic because brood on other threads read it to decide whether to lock (TransferCell()).
 	 */
-	bool m_isOpen;
+	std::atomic<bool> m_isOpen;
 	
 	/** 
 	 * @brief Simulated micro-environmental variation in development timing (days)
@@ -462,6 +745,13 @@ protected:
 	 */
 	int m_aspectdelay;
 
+	/**
+	 * @brief Microclimate class of the nest site (0 to OSMIA_MICROCLIMATE_CLASSES - 1)
+	 * @details Assigned once by Osmia_Nest_Manager::CreateNest() from the aspect delay and the
+	 * habitat type. Selects the nest's row in the daily per-class temperature tables.
+	 */
+	uint8_t m_MicroclimateClass = 1;
+
 public:
 	/**
 	 * @brief Construct a new Osmia_Nest object at specified location
@@ -499,7 +789,25 @@ public:
 	 * ReleaseCellLock();
 	 * @endcode
 	 */
+#ifdef __OSMIA_METRICS
+	void SetCellLock(void) {
+		// Only contended acquisitions are timed, so the uncontended path stays a single test
+		if (omp_test_nest_lock(m_cell_lock)) return;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		omp_set_nest_lock(m_cell_lock);
+		double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#pragma omp atomic
+		m_LockWaitSeconds += waited;
+	}
+
+	/** @brief Total time all threads have spent waiting for contended nest locks (seconds) */
+	static double m_LockWaitSeconds;
+
+	/** @brief Brood transitions that took the locked path in TransferCell() (open nests) */
+	static unsigned long m_LockedTransfers;
+#else
 	void SetCellLock(void) { omp_set_nest_lock(m_cell_lock); }
+#endif
 	
 	/**
 	 * @brief Release the nest lock after completing modifications
@@ -516,13 +824,14 @@ public:
 	 * overwintering individuals from previous seasons. Not used during normal simulation runtime where
 	 * eggs are added via AddEgg().
 	 * 
+	 * @return Slot index assigned to the cocoon
+	 * 
 	 * @par Implementation Note
-	 * Uses push_front() to add to forward_list, which is O(1). Initialisation order (back to front or
-	 * front to back) doesn't affect subsequent simulation as cocoons emerge based on temperature not
-	 * position in nest.
+	 * Appends to the slot vector exactly as AddEgg() does. Initialisation order doesn't affect
+	 * subsequent simulation as cocoons emerge based on temperature not position in nest.
 	 */
-	void AddCocoon (TAnimal* a_cocoon) {
-		m_cells.push_front(a_cocoon);
+	int AddCocoon (TAnimal* a_cocoon) {
+		return AddEgg(a_cocoon);
 	}
 	
 	/** 
@@ -539,41 +848,135 @@ public:
 	 * 
 	 * @par Thread Safety
 	 * Method acquires cell lock internally, so calling code does not need to lock explicitly.
+	 * 
+	 * @return Slot index of the new cell, to be stored in the egg's Osmia_Base::m_NestSlot
 	 */
-	void AddEgg (TAnimal* a_egg);
+	int AddEgg (TAnimal* a_egg);
 	
 	/**
 	 * @brief Replace a cell pointer during metamorphosis (egg→larva, larva→prepupa, etc.)
-	 * @param a_old_ptr Pointer to object being replaced (about to be deleted)
+	 * @param a_slot Slot index of the cell, carried over from the old object
 	 * @param a_new_ptr Pointer to new life stage object
 	 * 
 	 * @details When an individual transitions between life stages, the old object is deleted and a new
-	 * object of the appropriate class is created. This method updates the nest's cell list to point to
-	 * the new object whilst maintaining cell order.
-	 * 
-	 * @par Implementation Detail
-	 * Searches the forward_list for a_old_ptr and replaces it with a_new_ptr. Requires linear search
-	 * through list, but list lengths are short (typically <15 cells) so performance is acceptable.
+	 * object of the appropriate class is created. This method updates the nest's cell slot to point to
+	 * the new object whilst maintaining cell order. The alive bit is unchanged.
 	 * 
 	 * @par Thread Safety
 	 * Caller must hold nest lock before calling this method to prevent concurrent modifications during
 	 * pointer replacement.
 	 */
-	void ReplaceNestPointer(TAnimal* a_old_ptr, TAnimal* a_new_ptr);
+	void ReplaceNestPointer(int a_slot, TAnimal* a_new_ptr) {
+		if (a_slot >= 0) m_cells[a_slot] = a_new_ptr;
+	}
+
+	/**
+	 * @brief Hand a cell to the next life stage of its occupant, locking only if the nest is shared
+	 * @param a_slot Slot index of the cell, carried over from the old object
+	 * @param a_new_ptr Pointer to new life stage object
+	 * 
+	 * @details Called by the population manager for every brood transition.
+	 * 
+	 * @par Ownership
+	 * While a nest is open, its provisioning female appends cells and may reallocate m_cells, so
+	 * the nest is shared and the lock is taken. Once sealed, m_cells never changes size and each
+	 * slot is written only by its own occupant. No other thread touches that slot, so the pointer
+	 * is replaced without locking. Operations that cross cells (RemoveCell(),
+	 * KillAllSubsequentCells()) still lock internally, and bombylid kills are queued on the nest
+	 * manager.
+	 * 
+	 * @par Which Path Is Taken
+	 * Brood develop while their nest is still open: Osmia_Egg::st_Develop() only defers
+	 * mortality until the nest is sealed, and degree-days accumulate from laying. The first
+	 * eggs of a nest that takes longer to provision than an egg takes to develop hatch, and may
+	 * moult again, while their mother is still adding cells, and those transitions take the
+	 * locked path. Everything after sealing, including the long prepupa, pupa and cocoon
+	 * stages, is lock-free. With __OSMIA_METRICS the locked transitions are counted
+	 * (m_LockedTransfers) and exported with the lock wait time.
+	 */
+	void TransferCell(int a_slot, TAnimal* a_new_ptr) {
+		if (IsOpen()) {
+			SetCellLock();
+			ReplaceNestPointer(a_slot, a_new_ptr);
+			ReleaseCellLock();
+#ifdef __OSMIA_METRICS
+#pragma omp atomic
+			m_LockedTransfers++;
+#endif
+		}
+		else ReplaceNestPointer(a_slot, a_new_ptr);
+	}
+
+	/**
+	 * @brief Mark a cell as empty after its occupant dies or emerges
+	 * @param a_slot Slot index of the cell
+	 * @details Clears the alive bit. Safe to call more than once for the same slot. Acquires the
+	 * cell lock internally.
+	 */
+	void RemoveCell(int a_slot);
+
+	/**
+	 * @brief Check whether a cell still holds a living individual
+	 * @param a_slot Slot index of the cell
+	 * @return false once the cell has been emptied or queued by KillAllSubsequentCells();
+	 * untracked slots are always alive
+	 * @details Lock-free. Lets a queued victim stop developing before
+	 * Osmia_Nest_Manager::ProcessCellDeaths() removes it.
+	 */
+	bool IsCellAlive(int a_slot) {
+		if (a_slot < 0 || a_slot >= m_MaxTrackedCells) return true;
+		return ((m_alive.load(std::memory_order_relaxed) >> a_slot) & 1) != 0;
+	}
+
+	/**
+	 * @brief Empty a cell whose occupant is leaving, if it is still alive
+	 * @param a_slot Slot index of the cell
+	 * @return true if the cell was alive and is now empty; false if it had already been
+	 * killed, in which case the occupant must die instead of leaving
+	 * @details Test and clear under the cell lock, as in KillAllSubsequentCells(), so an
+	 * emerging bee and a bombylid emerging from an earlier cell cannot both claim the same slot.
+	 */
+	bool ClaimCell(int a_slot);
+
+	/**
+	 * @brief Kill every cell laid after the given one
+	 * @param a_slot Slot of the cell whose parasitoid is emerging
+	 * @details Used when a bombylid emerges: it leaves through the cells between it and the nest
+	 * entrance, which are those laid later. The later slots still alive are cleared from m_alive in
+	 * one mask operation and queued on the Osmia_Nest_Manager for batched death processing
+	 * (Osmia_Nest_Manager::ProcessCellDeaths()). Acquires the cell lock internally.
+	 */
+	void KillAllSubsequentCells(int a_slot);
+
+	/**
+	 * @brief Get the current occupant of a cell
+	 * @param a_slot Slot index
+	 * @return Pointer to the object in the slot (may already be dead)
+	 */
+	TAnimal* GetCellOccupant(int a_slot) { return m_cells[a_slot]; }
+
+	/**
+	 * @brief Get count of cells that still hold a living individual
+	 * @return Number of set bits in m_alive
+	 */
+	int GetLiveCellCount() {
+		int count = 0;
+		for (uint64_t mask = m_alive.load(); mask != 0; mask &= mask - 1) count++;
+		return count;
+	}
 	
 	/**
 	 * @brief Get count of cells currently in the nest
 	 * @return Number of cells (eggs + developing larvae)
 	 * 
-	 * @details Returns the current size of m_cells list. Used for monitoring nest provisioning progress
+	 * @details Returns the current size of the m_cells slot vector. Used for monitoring nest provisioning progress
 	 * and for calculating parasitism risk (which increases with nest cell count).
 	 * 
 	 * @par Usage Note
 	 * This count includes all cells added to date, including any that may have died. Dead cells are not
-	 * actively removed from the list; they simply cease to Step and remain as inactive pointers until
-	 * nest cleanup at season end.
+	 * removed from the slot vector; use GetLiveCellCount() for living cells only.
 	 */
-	int GetCellCount();
+	int GetCellCount() { return int(m_cells.size()); }
 	
 	/**
 	 * @brief Check if nest is open for adding new cells
@@ -581,8 +984,10 @@ public:
 	 * 
 	 * @details Returns m_isOpen status. Closed nests reject new egg additions. Status is managed by
 	 * the provisioning female, who sets it false when completing the nest or upon death.
+	 * Read atomically because brood on other threads use it to decide whether to lock
+	 * (TransferCell()).
 	 */
-	bool IsOpen() { return m_isOpen; }
+	bool IsOpen() { return m_isOpen.load(); }
 	
 	/**
 	 * @brief Set nest open/closed status
@@ -591,7 +996,7 @@ public:
 	 * @details Called by provisioning female when sealing the final nest cell or when abandoning a nest.
 	 * Also may be set false by population manager during cleanup of nests belonging to dead females.
 	 */
-	void SetIsOpen(bool a_status) { m_isOpen = a_status; }
+	void SetIsOpen(bool a_status) { m_isOpen.store(a_status); }
 	
 	/**
 	 * @brief Get nest X-coordinate
@@ -622,6 +1027,12 @@ public:
 	 * effects. Used by overwintering individuals to adjust emergence timing.
 	 */
 	int GetAspectDelay() { return m_aspectdelay; }
+
+	/** @brief Get the microclimate class of the nest site */
+	uint8_t GetMicroclimateClass() { return m_MicroclimateClass; }
+
+	/** @brief Set the microclimate class (called once when the nest is created) */
+	void SetMicroclimateClass(uint8_t a_class) { m_MicroclimateClass = a_class; }
 };
 
 /**
@@ -672,6 +1083,17 @@ protected:
 	 * developmental progress, environmental conditions, and mortality events.
 	 */
 	TTypeOfOsmiaState m_CurrentOState;
+
+	/**
+	 * @var m_DevelopOutcome
+	 * @brief Next state after a day of brood development, indexed [died][development complete]
+	 * @details The brood st_Develop() methods compute both conditions and look up the result,
+	 * so the choice of return state is a single indexed load rather than a chain of early
+	 * returns. The methods are not branch-free: the mortality draw is still only made for a
+	 * sealed nest, and the pesticide test only for a survivor, so that random draws keep their
+	 * order. Death takes precedence over completion, as in the original sequential logic.
+	 */
+	static const TTypeOfOsmiaState m_DevelopOutcome[2][2];
 	
 	/**
 	 * @var m_Age
@@ -721,6 +1143,14 @@ protected:
 	 * implemented as arrays rather than calculated values.
 	 */
 	static int m_TempTodayInt;
+
+	/**
+	 * @var m_Environment
+	 * @brief Today's global conditions, set once per day by the population manager
+	 * @details Passed by const reference to the stage development kernels.
+	 * @see OsmiaDailyEnvironment
+	 */
+	static OsmiaDailyEnvironment m_Environment;
 	
 	/**
 	 * @var m_DailyDevelopmentMortEggs
@@ -1353,6 +1783,58 @@ protected:
 	 * is dispersing or searching for nest location.
 	 */
 	Osmia_Nest* m_OurNest;
+
+	/**
+	 * @var m_NestSlot
+	 * @brief Slot index of this individual's cell in m_OurNest, in laying order
+	 * @details Assigned by Osmia_Nest::AddEgg() (or AddCocoon() at initialisation) and passed on
+	 * unchanged through each life-stage transition. -1 for adult females and untracked cells.
+	 */
+	int m_NestSlot;
+
+	/**
+	 * @var m_NestSealed
+	 * @brief Cached copy of "m_OurNest is sealed" for the brood stages
+	 * @details Set at creation from the nest passed in. While false, the development step reads
+	 * m_OurNest and latches the result here. Sealing is one-way, so once true the step never
+	 * follows m_OurNest again, and the sealed brood (most of it in any season) reads only its
+	 * own object.
+	 */
+	bool m_NestSealed;
+
+	/**
+	 * @var m_MicroclimateClass
+	 * @brief Cached microclimate class of m_OurNest, indexing the daily per-class tables
+	 * @details Set at creation from the nest. Nests never change class, so it is not refreshed.
+	 */
+	uint8_t m_MicroclimateClass;
+
+	/**
+	 * @var m_Species
+	 * @brief Index of this individual's species in m_SpeciesTraits (0 = *O. bicornis*)
+	 * @details Passed on unchanged through every life-stage transition and from mother to egg.
+	 */
+	uint8_t m_Species;
+
+	/**
+	 * @var m_SpeciesTraits
+	 * @brief Life-history constants of each simulated species
+	 * @details Entry 0 is filled from the configuration by SetParameterValues() and matches the
+	 * individual static parameters below. Further entries come from ReadSpeciesTraits().
+	 */
+	static OsmiaSpeciesTraits m_SpeciesTraits[OSMIA_MAX_SPECIES];
+
+	/** @brief Number of species in use (at least 1) */
+	static int m_NoSpecies;
+
+#ifdef __OSMIA_LINEAGE
+	/**
+	 * @var m_LineageID
+	 * @brief Identifier of this individual in the lineage log (see OsmiaLineageLog)
+	 * @details Assigned when the egg is laid and kept through every life stage. 0 = not recorded.
+	 */
+	uint64_t m_LineageID;
+#endif
 	
 	/**
 	 * @var m_Mass
@@ -1413,6 +1895,16 @@ public:
 	 * terminal state (DONE or DIE).
 	 */
 	virtual void Step(void) { ; }
+
+	/**
+	 * @brief Life stage of this object
+	 * @details Overridden by every stage class. Used where an individual is handled through an
+	 * Osmia_Base pointer and its stage matters (e.g. removing it from the spatial output rasters).
+	 */
+	virtual TTypeOfOsmiaLifeStages GetStage() const = 0;
+
+	/** @brief Remove this individual from its stage's spatial output raster (on death or emergence) */
+	void RemoveFromRaster();
 	
 	/**
 	 * @brief Final phase of daily timestep
@@ -1448,6 +1940,28 @@ public:
 	
 	/** @brief Get pointer to nest containing or being provisioned by this individual */
 	Osmia_Nest* GetNest() { return m_OurNest; }
+
+	/** @brief Get slot index of this individual's nest cell */
+	int GetNestSlot() { return m_NestSlot; }
+
+	/** @brief Set slot index of this individual's nest cell (called when the cell is created) */
+	void SetNestSlot(int a_slot) { m_NestSlot = a_slot; }
+
+	/**
+	 * @brief true once this individual's nest is sealed
+	 * @details Reads m_OurNest only until the nest has been seen sealed, then the cached flag.
+	 */
+	bool IsNestSealed() {
+		if (!m_NestSealed) m_NestSealed = !m_OurNest->IsOpen();
+		return m_NestSealed;
+	}
+
+#ifdef __OSMIA_LINEAGE
+	/** @brief Get the lineage identifier */
+	uint64_t GetLineageID() { return m_LineageID; }
+	/** @brief Set the lineage identifier (new eggs and founding cocoons) */
+	void SetLineageID(uint64_t a_id) { m_LineageID = a_id; }
+#endif
 	
 	/**
 	 * @brief Populate all static parameters from configuration file
@@ -1467,6 +1981,55 @@ public:
 		m_TempToday = a_temperature;
 		m_TempTodayInt = int(floor(a_temperature + 0.5)); 
 	}
+
+	/**
+	 * @brief Set today's environment snapshot for all individuals
+	 * @param a_env Conditions built by the population manager in DoFirst()
+	 * @details Also keeps m_TempToday and m_TempTodayInt in step with the snapshot.
+	 */
+	static void SetEnvironment(const OsmiaDailyEnvironment& a_env) {
+		m_Environment = a_env;
+		SetTemp(a_env.m_Temp);
+	}
+
+	/** @brief Today's environment snapshot */
+	static const OsmiaDailyEnvironment& GetEnvironment() { return m_Environment; }
+
+	/**
+	 * @brief Fill the per-class degree-day increments of a snapshot from its class temperatures
+	 * @param a_env Snapshot whose m_ClassTemp is already set
+	 * @details Uses the stage development thresholds, so the tables match the per-individual
+	 * calculation max(temperature - threshold, 0) exactly.
+	 */
+	static void SetDevelopmentIncrements(OsmiaDailyEnvironment& a_env);
+
+	/** @brief Life-history constants of this individual's species */
+	const OsmiaSpeciesTraits& Traits() const { return m_SpeciesTraits[m_Species]; }
+
+	/** @brief Species index of this individual */
+	uint8_t GetSpecies() const { return m_Species; }
+
+	/** @brief Number of species in use */
+	static int GetNoSpecies() { return m_NoSpecies; }
+
+	/** @brief Life-history constants of a species */
+	static const OsmiaSpeciesTraits& GetSpeciesTraits(int a_species) { return m_SpeciesTraits[a_species]; }
+
+	/**
+	 * @brief Add the species listed in a species traits file after *O. bicornis*
+	 * @param a_filename File in the format described for OsmiaSpeciesTraits
+	 * @param a_error Set to a description of the problem on failure
+	 * @return false if the file cannot be read, a key is unknown or there are too many species
+	 * @details Must be called after SetParameterValues(), since unlisted keys copy species 0.
+	 */
+	static bool ReadSpeciesTraits(const string& a_filename, string& a_error);
+
+	/**
+	 * @brief Choose the species of a founding individual from the species' initial fractions
+	 * @details With a single species no random number is drawn, so single-species runs keep
+	 * their random sequence.
+	 */
+	static uint8_t PickFounderSpecies();
 	
 	/**
 	 * @brief Set parasitoid population manager pointer
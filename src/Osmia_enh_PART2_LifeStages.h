@@ -109,6 +109,9 @@ public:
 	 * mortality test. Transitions to Osmia_Larva upon hatching or to death upon mortality.
 	 */
 	virtual void Step(void);
+
+	/** @brief Life stage of this object */
+	virtual TTypeOfOsmiaLifeStages GetStage() const;
 	
 	/** @brief Get accumulated degree-days */
 	double GetAgeDegrees() { return m_AgeDegrees; }
@@ -119,6 +122,7 @@ public:
 protected:
 	/**
 	 * @brief Development state - accumulate degree-days toward hatching
+	 * @param a_env Today's environment snapshot (temperature, date, phenology flags)
 	 * @return Next state (st_Hatch if threshold reached, st_Develop to continue, or st_Die)
 	 * 
 	 * @details Each day:
@@ -137,7 +141,7 @@ protected:
 	 * **IMPLEMENTATION MATCH** - Logic follows formal model specification exactly. Parameter values
 	 * differ (see Osmia_Base documentation) but algorithm structure is identical.
 	 */
-	virtual TTypeOfOsmiaState st_Develop(void);
+	virtual TTypeOfOsmiaState st_Develop(const OsmiaDailyEnvironment& a_env);
 	
 	/**
 	 * @brief Transition state - metamorphose from egg to larva
@@ -174,7 +178,7 @@ protected:
 	 * choice given uncertainty.
 	 */
 	virtual bool DailyMortality() { 
-		if (g_rand_uni_fnc() < m_DailyDevelopmentMortEggs) return true; 
+		if (g_rand_uni_fnc() < Traits().m_EggDailyMort) return true; 
 		else return false; 
 	}
 };
@@ -243,9 +247,13 @@ public:
 	 */
 	virtual void Step(void);
 
+	/** @brief Life stage of this object */
+	virtual TTypeOfOsmiaLifeStages GetStage() const;
+
 protected:
 	/**
 	 * @brief Development state - accumulate degree-days toward prepupation
+	 * @param a_env Today's environment snapshot (temperature, date, phenology flags)
 	 * @return Next state (st_Prepupate if threshold reached, st_Develop to continue, or st_Die)
 	 * 
 	 * @details Development logic parallel to egg stage but with larval parameters:
@@ -264,7 +272,7 @@ protected:
 	 * can lead to slightly shorter larval duration and vice versa, creating realistic thermal
 	 * integration across stages.
 	 */
-	virtual TTypeOfOsmiaState st_Develop(void);
+	virtual TTypeOfOsmiaState st_Develop(const OsmiaDailyEnvironment& a_env);
 	
 	/**
 	 * @brief Transition state - metamorphose from larva to prepupa
@@ -292,7 +300,7 @@ protected:
 	 * survival.
 	 */
 	virtual bool DailyMortality() { 
-		if (g_rand_uni_fnc() < m_DailyDevelopmentMortLarvae) return true; 
+		if (g_rand_uni_fnc() < Traits().m_LarvaDailyMort) return true; 
 		else return false; 
 	}
 };
@@ -344,9 +352,13 @@ public:
 	/** @brief Main step function */
 	virtual void Step(void);
 
+	/** @brief Life stage of this object */
+	virtual TTypeOfOsmiaLifeStages GetStage() const;
+
 protected:
 	/**
 	 * @brief Development state - time-based progression toward pupation
+	 * @param a_env Today's environment snapshot (temperature, date, phenology flags)
 	 * @return Next state (st_Pupate when duration complete, st_Develop to continue, or st_Die)
 	 * 
 	 * @details Different development logic from egg/larva:
@@ -365,7 +377,7 @@ protected:
 	 * Each prepupa gets individual m_myOsmiaPrepupaDevelTotalDays drawn from uniform distribution
 	 * (base ± 10%), creating realistic spread in prepupal durations even under identical temperatures.
 	 */
-	virtual TTypeOfOsmiaState st_Develop(void);
+	virtual TTypeOfOsmiaState st_Develop(const OsmiaDailyEnvironment& a_env);
 	
 	/**
 	 * @brief Transition state - metamorphose from prepupa to pupa
@@ -382,7 +394,7 @@ protected:
 	 * Cocooned prepupae are well-protected.
 	 */
 	virtual bool DailyMortality() { 
-		if (g_rand_uni_fnc() < m_DailyDevelopmentMortPrepupae) return true; 
+		if (g_rand_uni_fnc() < Traits().m_PrepupaDailyMort) return true; 
 		else return false; 
 	}
 	
@@ -448,9 +460,13 @@ public:
 	/** @brief Main step function */
 	virtual void Step(void);
 
+	/** @brief Life stage of this object */
+	virtual TTypeOfOsmiaLifeStages GetStage() const;
+
 protected:
 	/**
 	 * @brief Development state - accumulate degree-days toward eclosion
+	 * @param a_env Today's environment snapshot (temperature, date, phenology flags)
 	 * @return Next state (st_Emerge when DD threshold reached, st_Develop to continue, or st_Die)
 	 * 
 	 * @details Standard degree-day logic:
@@ -468,7 +484,7 @@ protected:
 	 * from imaginal discs whilst larval tissues are remodelled. Process requires substantial energy
 	 * and time, reflected in high DD requirement.
 	 */
-	virtual TTypeOfOsmiaState st_Develop(void);
+	virtual TTypeOfOsmiaState st_Develop(const OsmiaDailyEnvironment& a_env);
 	
 	/**
 	 * @brief Transition state - eclosion from pupa to adult-in-cocoon
@@ -496,7 +512,7 @@ protected:
 	 * to fail (not explicitly modelled - assumed rare).
 	 */
 	virtual bool DailyMortality() { 
-		if (g_rand_uni_fnc() < m_DailyDevelopmentMortPupae) return true; 
+		if (g_rand_uni_fnc() < Traits().m_PupaDailyMort) return true; 
 		else return false; 
 	}
 };
@@ -145,6 +145,9 @@ public:
 	 * 4. Transition to emergence or continue overwintering
 	 */
 	virtual void Step(void);
+
+	/** @brief Life stage of this object */
+	virtual TTypeOfOsmiaLifeStages GetStage() const;
 	
 	/**
 	 * @brief Set overwintering temperature threshold (static parameter)
@@ -164,6 +167,7 @@ public:
 protected:
 	/**
 	 * @brief Development state - manage overwintering phases and emergence preparation
+	 * @param a_env Today's environment snapshot (temperature, date, phenology flags)
 	 * @return Next state (st_Emerge when ready, st_Develop to continue, or st_Die)
 	 * 
 	 * @details Complex multi-phase logic:
@@ -212,7 +216,7 @@ protected:
 	 * continuous threshold checks rather than explicit phase flags is consistent with formal model
 	 * emphasis on emergent behaviour from temperature-threshold interactions.
 	 */
-	virtual TTypeOfOsmiaState st_Develop(void);
+	virtual TTypeOfOsmiaState st_Develop(const OsmiaDailyEnvironment& a_env);
 	
 	/**
 	 * @brief Transition state - emerge from cocoon as active adult
@@ -404,10 +408,23 @@ protected:
 	 * @var m_foragemaskdetailed
 	 * @brief Static high-resolution spatial search mask
 	 * @details Alternative mask with finer spatial resolution for detailed pollen assessment. Used when
-	 * comprehensive resource evaluation needed rather than incremental search.
+	 * comprehensive resource evaluation needed rather than incremental search. With several body-size
+	 * range classes the offsets are sorted by distance and a female reads only the first
+	 * GetForageMaskSize() of them.
 	 */
 	static OsmiaForageMaskDetailed m_foragemaskdetailed;
 	
+	/**
+	 * @var m_foragemaskcatalogue
+	 * @brief Body-size range classes over m_foragemaskdetailed
+	 * @details Shared by all females; each female selects her class from her mass through
+	 * GetForageRangeClass(), so no per-female mask is stored.
+	 */
+	static OsmiaForageMaskCatalogue m_foragemaskcatalogue;
+	
+	/** @brief Allometric exponent of foraging range on mass (see ForageRange()) */
+	static double m_ForageRangeMassExponent;
+	
 	/**
 	 * @var m_currentpollenlevel
 	 * @brief Current pollen availability at active foraging location
@@ -627,8 +644,12 @@ protected:
 	 * @par Biological Basis
 	 * Young bees need practice to optimize foraging routes and flower handling. Old bees experience
 	 * cumulative wing wear and muscle degradation reducing flight speed and cargo capacity.
+	 *
+	 * @par Storage
+	 * Covers ages 0-364, and reads clamp to that range, so a female living longer than the
+	 * configured lifespan (OSMIA_LIFESPAN) never indexes past the table.
 	 */
-	static vector<double> m_FemaleForageEfficiency;
+	static OsmiaAgeTable m_FemaleForageEfficiency;
 	
 	/**
 	 * @var m_ForageLocX
@@ -737,7 +758,10 @@ protected:
 	 * maturation period (first few days post-emergence before reproduction begins).
 	 */
 	virtual TTypeOfOsmiaState st_Develop(void);
-	
+
+	/** @brief Keep the cocoon stage's environment overload visible alongside the adult hook above */
+	using Osmia_InCocoon::st_Develop;
+
 	/**
 	 * @brief Search for suitable nest cavity
 	 * @return true if nest found, false if search fails
@@ -1031,6 +1055,9 @@ public:
 	 * - Records emergence location (becomes dispersal origin)
 	 */
 	Osmia_Female(struct_Osmia* data);
+
+	/** @brief Remaining lifetime egg load (used by the population manager to predict egg numbers) */
+	int GetEggsToLay() const { return m_EggsToLay; }
 	
 	/**
 	 * @brief Reinitialize from object pool
@@ -1072,6 +1099,9 @@ public:
 	 * Loops until state machine returns terminal state (DONE or DIE).
 	 */
 	virtual void Step(void);
+
+	/** @brief Life stage of this object */
+	virtual TTypeOfOsmiaLifeStages GetStage() const;
 	
 	//----------------------- Static Setters (Population Manager Initialization) -----------------------
 	
@@ -1088,6 +1118,65 @@ public:
 		m_foragemaskdetailed = fmd;
 	}
 	
+	/**
+	 * @brief Split the detailed mask into body-size foraging range classes
+	 * @param a_noclasses Number of range classes
+	 * @param a_exponent Allometric exponent of range on mass
+	 * @details Must follow SetForageMaskDetailed() and ReadSpeciesTraits(). The class ranges span
+	 * the smallest and largest female of every species; with one class the detailed mask is kept
+	 * whole.
+	 */
+	static void SetForageRangeClasses(int a_noclasses, double a_exponent) {
+		m_ForageRangeMassExponent = a_exponent;
+		double minrange = m_foragemaskdetailed.m_maxdistance;
+		double maxrange = minrange;
+		if (a_noclasses > 1) {
+			minrange = ForageRange(GetSpeciesTraits(0), GetSpeciesTraits(0).m_FemaleMinMass);
+			maxrange = ForageRange(GetSpeciesTraits(0), GetSpeciesTraits(0).m_FemaleMaxMass);
+			for (int s = 1; s < GetNoSpecies(); s++) {
+				const OsmiaSpeciesTraits& traits = GetSpeciesTraits(s);
+				minrange = min(minrange, ForageRange(traits, traits.m_FemaleMinMass));
+				maxrange = max(maxrange, ForageRange(traits, traits.m_FemaleMaxMass));
+			}
+		}
+		m_foragemaskcatalogue.Configure(a_noclasses, minrange, maxrange, m_foragemaskdetailed);
+	}
+	
+	/**
+	 * @brief Foraging range of a female of given species and mass (m)
+	 * @details The species' typical homing distance scaled allometrically from the mid-range
+	 * female mass, limited to between one mask step and the maximum homing distance.
+	 */
+	static double ForageRange(const OsmiaSpeciesTraits& a_traits, double a_mass) {
+		double refmass = 0.5 * (a_traits.m_FemaleMinMass + a_traits.m_FemaleMaxMass);
+		double range = a_traits.m_TypicalHomingDistance;
+		if (refmass > 0.0) range *= pow(a_mass / refmass, m_ForageRangeMassExponent);
+		return max(double(m_foragemaskdetailed.m_step), min(range, a_traits.m_MaxHomingDistance));
+	}
+	
+	/** @brief This female's foraging range from her species and mass (m) */
+	double GetForageRange() const { return ForageRange(Traits(), m_Mass); }
+	
+	/** @brief This female's body-size range class */
+	int GetForageRangeClass() const { return m_foragemaskcatalogue.GetRangeClass(GetForageRange()); }
+	
+	/**
+	 * @brief Number of leading m_foragemaskdetailed offsets this female searches
+	 * @details The detailed search walks m_foragemaskdetailed.m_mask[0 .. GetForageMaskSize()),
+	 * which is the whole mask with one range class.
+	 */
+	size_t GetForageMaskSize() const { return m_foragemaskcatalogue.GetMaskSize(GetForageRangeClass()); }
+	
+	/**
+	 * @brief Number of m_foragemask distance rings this female searches
+	 * @details Rings are m_foragemask.m_step apart from the nest, so the coarse search stops at
+	 * the first ring beyond the female's range. With one range class every ring is searched.
+	 */
+	int GetForageRings() const {
+		if (m_foragemaskcatalogue.GetNoClasses() <= 1 || m_foragemask.m_step <= 0) return m_ForageSteps;
+		return min(m_ForageSteps, int(GetForageRange() / m_foragemask.m_step) + 1);
+	}
+	
 	/** @brief Set proportional give-up threshold for patch abandonment */
 	static void SetPollenGiveUpThreshold(double a_prop) { m_pollengiveupthreshold = a_prop; }
 	
@@ -1158,8 +1247,17 @@ public:
 	/** @brief Set density-dependent pollen removal constant (instance method) */
 	void SetDensityDependentPollenRemovalConst(double a_value) { m_DensityDependentPollenRemovalConst = a_value; }
 	
-	/** @brief Add age-specific foraging efficiency value to vector */
-	static void AddForageEfficiency(double a_eff) { m_FemaleForageEfficiency.push_back(a_eff); }
+	/** @brief Set the age-specific foraging efficiency table from values for ages 0 to a_n-1 */
+	static void SetForageEfficiency(const double* a_eff, size_t a_n) { m_FemaleForageEfficiency.Fill(a_eff, a_n); }
+
+	/** @brief Get the age-specific foraging efficiency table */
+	static const OsmiaAgeTable& GetForageEfficiencyTable() { return m_FemaleForageEfficiency; }
+
+	/** @brief Foraging efficiency at an adult age, clamped to the table */
+	static double GetForageEfficiency(int a_age) { return m_FemaleForageEfficiency[a_age]; }
+
+	/** @brief Foraging efficiency for a batch of ages, e.g. one pass over all females */
+	static void GatherForageEfficiency(const int* a_ages, double* a_eff, size_t a_n) { m_FemaleForageEfficiency.Gather(a_ages, a_eff, a_n); }
 	
 	/**
 	 * @brief Get available pollen in polygon from starting location
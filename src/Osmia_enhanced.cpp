@@ -84,6 +84,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <fstream>
 #include <vector>
 #include <random>
+#include <algorithm>
+#include <sstream>
 
 
 #pragma warning( push )
@@ -1399,6 +1401,132 @@ CfgBool cfg_OsmiaEggThresholdBasedPesticideResponse("OSMIA_EGG_THRESHOLD_BASED_P
 static std::uniform_int_distribution<int> g_uni_0to15(0, 35);
 extern std::mt19937 g_generator;
 
+//===========================================================================
+// OSMIA_NEST CLASS IMPLEMENTATION (cell slots)
+//===========================================================================
+
+/**
+ * @brief Append a new cell to the nest in laying order
+ * @details The new cell gets the next slot index and its alive bit is set. Cells beyond
+ * m_MaxTrackedCells are stored but not tracked in the alive mask.
+ * 
+ * @param a_egg Pointer to the new occupant (an egg, or a cocoon at initialisation)
+ * @return Slot index of the new cell
+ */
+int Osmia_Nest::AddEgg(TAnimal* a_egg)
+{
+	SetCellLock();
+	int slot = int(m_cells.size());
+	m_cells.push_back(a_egg);
+	if (slot < m_MaxTrackedCells) m_alive.fetch_or(uint64_t(1) << slot);
+	ReleaseCellLock();
+	return slot;
+}
+
+/**
+ * @brief Clear the alive bit for a cell
+ * @param a_slot Slot index; ignored if negative or untracked
+ */
+void Osmia_Nest::RemoveCell(int a_slot)
+{
+	if (a_slot < 0 || a_slot >= m_MaxTrackedCells) return;
+	SetCellLock();
+	m_alive.fetch_and(~(uint64_t(1) << a_slot));
+	ReleaseCellLock();
+}
+
+bool Osmia_Nest::ClaimCell(int a_slot)
+{
+	if (a_slot < 0 || a_slot >= m_MaxTrackedCells) return true;
+	uint64_t bit = uint64_t(1) << a_slot;
+	SetCellLock();
+	bool alive = (m_alive.fetch_and(~bit) & bit) != 0;
+	ReleaseCellLock();
+	return alive;
+}
+
+/**
+ * @brief Kill all cells laid after a_slot
+ * @details The mask of later slots is every bit above a_slot. Those still alive are cleared
+ * at once and each is queued on the nest manager. The occupants themselves are killed later,
+ * in Osmia_Nest_Manager::ProcessCellDeaths(), so an emerging bee never kills a sibling that
+ * another thread may be stepping.
+ * 
+ * @param a_slot Slot of the cell containing the emerging bombylid
+ */
+void Osmia_Nest::KillAllSubsequentCells(int a_slot)
+{
+	if (a_slot < 0 || a_slot >= m_MaxTrackedCells - 1) return;
+	SetCellLock();
+	uint64_t victims = m_alive.load() & ~((uint64_t(2) << a_slot) - 1);
+	m_alive.fetch_and(~victims);
+	ReleaseCellLock();
+	victims >>= a_slot + 1;
+	for (int slot = a_slot + 1; victims != 0; slot++, victims >>= 1) {
+		if (victims & 1) m_OurManager->QueueCellDeath(this, slot);
+	}
+}
+
+//===========================================================================
+// FORAGE MASK CATALOGUE
+//===========================================================================
+
+/**
+ * @details With several classes every step-spaced offset within the largest range is listed
+ * once, sorted by squared distance with ties broken by y then x so the order does not depend on
+ * the platform's sort, and written back into a_mask. Each class end is then found by a binary
+ * search on the sorted distances. With one class a_mask keeps its constructed offsets.
+ */
+void OsmiaForageMaskCatalogue::Configure(int a_noclasses, double a_minrange, double a_maxrange, OsmiaForageMaskDetailed& a_mask) {
+	int noclasses = max(1, a_noclasses);
+	m_ClassRange.resize(noclasses);
+	m_ClassEnd.resize(noclasses);
+	if (noclasses == 1) {
+		m_ClassRange[0] = a_maxrange;
+		m_ClassEnd[0] = a_mask.m_mask.size();
+		return;
+	}
+	for (int c = 0; c < noclasses; c++) {
+		m_ClassRange[c] = a_minrange + (a_maxrange - a_minrange) * c / (noclasses - 1);
+	}
+	int step = max(1, a_mask.m_step);
+	int reach = int(a_maxrange) / step;
+	long long reach2 = (long long)(a_maxrange * a_maxrange);
+	vector<pair<long long, APoint>> sorted;
+	for (int dy = -reach; dy <= reach; dy++) {
+		for (int dx = -reach; dx <= reach; dx++) {
+			APoint pt;
+			pt.m_x = dx * step;
+			pt.m_y = dy * step;
+			long long d2 = (long long)pt.m_x * pt.m_x + (long long)pt.m_y * pt.m_y;
+			if (d2 <= reach2) sorted.push_back(make_pair(d2, pt));
+		}
+	}
+	sort(sorted.begin(), sorted.end(), [](const pair<long long, APoint>& a, const pair<long long, APoint>& b) {
+		if (a.first != b.first) return a.first < b.first;
+		if (a.second.m_y != b.second.m_y) return a.second.m_y < b.second.m_y;
+		return a.second.m_x < b.second.m_x;
+	});
+	a_mask.m_mask.resize(sorted.size());
+	for (size_t i = 0; i < sorted.size(); i++) a_mask.m_mask[i] = sorted[i].second;
+	a_mask.m_step = step;
+	a_mask.m_maxdistance = int(ceil(a_maxrange));
+	for (int c = 0; c < noclasses; c++) {
+		long long r2 = (long long)(m_ClassRange[c] * m_ClassRange[c]);
+		auto end = upper_bound(sorted.begin(), sorted.end(), r2, [](long long v, const pair<long long, APoint>& e) { return v < e.first; });
+		m_ClassEnd[c] = size_t(end - sorted.begin());
+	}
+}
+
+int OsmiaForageMaskCatalogue::GetRangeClass(double a_range) const {
+	int last = int(m_ClassRange.size()) - 1;
+	if (last <= 0) return 0;
+	double width = (m_ClassRange[last] - m_ClassRange[0]) / last;
+	if (width <= 0.0) return 0;
+	int c = int(floor((a_range - m_ClassRange[0]) / width + 0.5));
+	return min(max(c, 0), last);
+}
+
 //===========================================================================
 // OSMIA_BASE CLASS IMPLEMENTATION
 //===========================================================================
@@ -1447,11 +1575,135 @@ void Osmia_Base::ReInit(struct_Osmia* data) {
 	// Assign the pointer to the population manager
 	m_OurPopulationManager = data->OPM;
 	m_CurrentOState = toOsmias_InitialState;
+	m_NestSlot = data->nestslot;
+	m_NestSealed = (data->nest != NULL) && !data->nest->IsOpen();
+	m_MicroclimateClass = (data->nest != NULL) ? data->nest->GetMicroclimateClass() : 1;
+	m_Species = data->species;
+#ifdef __OSMIA_LINEAGE
+	m_LineageID = data->lineageid;
+#endif
 	SetAge(data->age); // Set the age
 	SetMass(data->mass);
 	SetParasitised(data->parasitised);
 }
 
+/**
+ * @brief Compute today's per-class development increments for the brood stages
+ * @param a_env Snapshot with m_ClassTemp already filled by the population manager
+ * @details Called once per day from Osmia_Population_Manager::DoFirst(). The egg, larva and
+ * pupa increments are the degree-days above each stage's lower developmental threshold. The
+ * prepupal increment is temperature-indexed and filled by the manager, which owns that table.
+ */
+void Osmia_Base::SetDevelopmentIncrements(OsmiaDailyEnvironment& a_env) {
+	for (int sp = 0; sp < m_NoSpecies; sp++) {
+		const OsmiaSpeciesTraits& traits = m_SpeciesTraits[sp];
+		for (int c = 0; c < OSMIA_MICROCLIMATE_CLASSES; c++) {
+			a_env.m_ClassEggDD[sp][c] = max(a_env.m_ClassTemp[c] - traits.m_EggDevelThreshold, 0.0);
+			a_env.m_ClassLarvaDD[sp][c] = max(a_env.m_ClassTemp[c] - traits.m_LarvaDevelThreshold, 0.0);
+			a_env.m_ClassPupaDD[sp][c] = max(a_env.m_ClassTemp[c] - traits.m_PupaDevelThreshold, 0.0);
+		}
+	}
+}
+
+/**
+ * @brief Member table used to parse species traits files
+ * @details Keys are the OsmiaSpeciesTraits member names without their m_ prefix.
+ */
+static const struct { const char* m_Key; double OsmiaSpeciesTraits::* m_Member; } g_OsmiaSpeciesTraitKeys[] = {
+	{ "EggDevelThreshold", &OsmiaSpeciesTraits::m_EggDevelThreshold },
+	{ "EggDevelTotalDD", &OsmiaSpeciesTraits::m_EggDevelTotalDD },
+	{ "LarvaDevelThreshold", &OsmiaSpeciesTraits::m_LarvaDevelThreshold },
+	{ "LarvaDevelTotalDD", &OsmiaSpeciesTraits::m_LarvaDevelTotalDD },
+	{ "PrepupaDevelTotalDays", &OsmiaSpeciesTraits::m_PrepupaDevelTotalDays },
+	{ "PupaDevelThreshold", &OsmiaSpeciesTraits::m_PupaDevelThreshold },
+	{ "PupaDevelTotalDD", &OsmiaSpeciesTraits::m_PupaDevelTotalDD },
+	{ "InCocoonOverwinteringTempThreshold", &OsmiaSpeciesTraits::m_InCocoonOverwinteringTempThreshold },
+	{ "InCocoonEmergenceTempThreshold", &OsmiaSpeciesTraits::m_InCocoonEmergenceTempThreshold },
+	{ "InCocoonPrewinteringTempThreshold", &OsmiaSpeciesTraits::m_InCocoonPrewinteringTempThreshold },
+	{ "InCocoonEmergCountConst", &OsmiaSpeciesTraits::m_InCocoonEmergCountConst },
+	{ "InCocoonEmergCountSlope", &OsmiaSpeciesTraits::m_InCocoonEmergCountSlope },
+	{ "InCocoonWinterMortConst", &OsmiaSpeciesTraits::m_InCocoonWinterMortConst },
+	{ "InCocoonWinterMortSlope", &OsmiaSpeciesTraits::m_InCocoonWinterMortSlope },
+	{ "EggDailyMort", &OsmiaSpeciesTraits::m_EggDailyMort },
+	{ "LarvaDailyMort", &OsmiaSpeciesTraits::m_LarvaDailyMort },
+	{ "PrepupaDailyMort", &OsmiaSpeciesTraits::m_PrepupaDailyMort },
+	{ "PupaDailyMort", &OsmiaSpeciesTraits::m_PupaDailyMort },
+	{ "FemaleMassFromProvMassConst", &OsmiaSpeciesTraits::m_FemaleMassFromProvMassConst },
+	{ "FemaleMassFromProvMassSlope", &OsmiaSpeciesTraits::m_FemaleMassFromProvMassSlope },
+	{ "FemaleMinMass", &OsmiaSpeciesTraits::m_FemaleMinMass },
+	{ "FemaleMaxMass", &OsmiaSpeciesTraits::m_FemaleMaxMass },
+	{ "TypicalHomingDistance", &OsmiaSpeciesTraits::m_TypicalHomingDistance },
+	{ "MaxHomingDistance", &OsmiaSpeciesTraits::m_MaxHomingDistance },
+	{ "InitialFraction", &OsmiaSpeciesTraits::m_InitialFraction }
+};
+
+/**
+ * @details Each non-comment line adds one species. The species starts as a copy of species 0 so
+ * that a file only needs to list where a species differs from *O. bicornis*. Only traits that
+ * the per-species code reads are accepted; any other key is an error rather than silently ignored.
+ */
+bool Osmia_Base::ReadSpeciesTraits(const string& a_filename, string& a_error) {
+	ifstream ifile(a_filename);
+	if (!ifile.is_open()) {
+		a_error = "cannot open " + a_filename;
+		return false;
+	}
+	string line;
+	while (getline(ifile, line)) {
+		istringstream fields(line);
+		string name;
+		if (!(fields >> name) || name[0] == '#') continue;
+		if (m_NoSpecies >= OSMIA_MAX_SPECIES) {
+			a_error = "more than OSMIA_MAX_SPECIES species in " + a_filename;
+			return false;
+		}
+		OsmiaSpeciesTraits traits = m_SpeciesTraits[0];
+		traits.m_Name = name;
+		traits.m_InitialFraction = 0.0;
+		string pair;
+		while (fields >> pair) {
+			size_t eq = pair.find('=');
+			bool found = false;
+			if (eq != string::npos) {
+				string key = pair.substr(0, eq);
+				for (const auto& k : g_OsmiaSpeciesTraitKeys) {
+					if (key == k.m_Key) {
+						traits.*(k.m_Member) = atof(pair.c_str() + eq + 1);
+						found = true;
+						break;
+					}
+				}
+			}
+			if (!found) {
+				a_error = "unknown species trait " + pair + " for " + name;
+				return false;
+			}
+		}
+		if (traits.m_InitialFraction < 0.0) {
+			a_error = "negative InitialFraction for " + name;
+			return false;
+		}
+		m_SpeciesTraits[m_NoSpecies++] = traits;
+	}
+	double founders = 0.0;
+	for (int sp = 1; sp < m_NoSpecies; sp++) founders += m_SpeciesTraits[sp].m_InitialFraction;
+	if (founders > 1.0) {
+		a_error = "InitialFraction values in " + a_filename + " sum to more than 1";
+		return false;
+	}
+	return true;
+}
+
+uint8_t Osmia_Base::PickFounderSpecies() {
+	if (m_NoSpecies == 1) return 0;
+	double draw = g_rand_uni_fnc();
+	for (int sp = 1; sp < m_NoSpecies; sp++) {
+		draw -= m_SpeciesTraits[sp].m_InitialFraction;
+		if (draw < 0.0) return uint8_t(sp);
+	}
+	return 0;
+}
+
 /**
  * @brief Destructor for Osmia_Base
  * @details Empty destructor as cleanup is handled elsewhere. Base class destructor will be called
@@ -1524,6 +1776,35 @@ void Osmia_Base::SetParameterValues() {
 	// Life history parameters
 	m_OsmiaFemalePrenesting = cfg_OsmiaFemalePrenestingDuration.value();
 	m_OsmiaFemaleLifespan = cfg_OsmiaFemaleLifespan.value();
+
+	// Species 0 mirrors the values above; further species are added by ReadSpeciesTraits()
+	OsmiaSpeciesTraits& bicornis = m_SpeciesTraits[0];
+	bicornis.m_EggDevelThreshold = m_OsmiaEggDevelThreshold;
+	bicornis.m_EggDevelTotalDD = m_OsmiaEggDevelTotalDD;
+	bicornis.m_LarvaDevelThreshold = m_OsmiaLarvaDevelThreshold;
+	bicornis.m_LarvaDevelTotalDD = m_OsmiaLarvaDevelTotalDD;
+	bicornis.m_PrepupaDevelTotalDays = m_OsmiaPrepupalDevelTotalDays;
+	bicornis.m_PupaDevelThreshold = m_OsmiaPupaDevelThreshold;
+	bicornis.m_PupaDevelTotalDD = m_OsmiaPupaDevelTotalDD;
+	bicornis.m_InCocoonOverwinteringTempThreshold = m_OsmiaInCocoonOverwinteringTempThreshold;
+	bicornis.m_InCocoonEmergenceTempThreshold = m_OsmiaInCocoonEmergenceTempThreshold;
+	bicornis.m_InCocoonPrewinteringTempThreshold = m_OsmiaInCocoonPrewinteringTempThreshold;
+	bicornis.m_InCocoonEmergCountConst = m_OsmiaInCocoonEmergCountConst;
+	bicornis.m_InCocoonEmergCountSlope = m_OsmiaInCocoonEmergCountSlope;
+	bicornis.m_InCocoonWinterMortConst = m_OsmiaInCocoonWinterMortConst;
+	bicornis.m_InCocoonWinterMortSlope = m_OsmiaInCocoonWinterMortSlope;
+	bicornis.m_EggDailyMort = m_DailyDevelopmentMortEggs;
+	bicornis.m_LarvaDailyMort = m_DailyDevelopmentMortLarvae;
+	bicornis.m_PrepupaDailyMort = m_DailyDevelopmentMortPrepupae;
+	bicornis.m_PupaDailyMort = m_DailyDevelopmentMortPupae;
+	bicornis.m_FemaleMassFromProvMassConst = m_OsmiaFemaleMassFromProvMassConst;
+	bicornis.m_FemaleMassFromProvMassSlope = m_OsmiaFemaleMassFromProvMassSlope;
+	bicornis.m_FemaleMinMass = m_FemaleMinMass;
+	bicornis.m_FemaleMaxMass = m_FemaleMaxMass;
+	bicornis.m_TypicalHomingDistance = m_OsmiaFemaleR50distance;
+	bicornis.m_MaxHomingDistance = m_OsmiaFemaleR90distance;
+	bicornis.m_InitialFraction = 1.0;
+	m_NoSpecies = 1;
 }
 
 /**
@@ -1541,9 +1822,37 @@ void Osmia_Base::SetParameterValues() {
  */
 void Osmia_Base::st_Dying( void )
 {
+	RemoveFromRaster();
 	KillThis(); // this will kill the animal object and free up space
-	m_OurNest->RemoveCell(this);
+	m_OurNest->RemoveCell(m_NestSlot);
+}
+//===========================================================================
+// LIFE STAGE IDENTITY
+//===========================================================================
+
+/*
+ * Defined here rather than inline because TTypeOfOsmiaLifeStages is only complete once the
+ * population manager header has been included.
+ */
+TTypeOfOsmiaLifeStages Osmia_Egg::GetStage() const { return TTypeOfOsmiaLifeStages::to_OsmiaEgg; }
+TTypeOfOsmiaLifeStages Osmia_Larva::GetStage() const { return TTypeOfOsmiaLifeStages::to_OsmiaLarva; }
+TTypeOfOsmiaLifeStages Osmia_Prepupa::GetStage() const { return TTypeOfOsmiaLifeStages::to_OsmiaPrepupa; }
+TTypeOfOsmiaLifeStages Osmia_Pupa::GetStage() const { return TTypeOfOsmiaLifeStages::to_OsmiaPupa; }
+TTypeOfOsmiaLifeStages Osmia_InCocoon::GetStage() const { return TTypeOfOsmiaLifeStages::to_OsmiaInCocoon; }
+TTypeOfOsmiaLifeStages Osmia_Female::GetStage() const { return TTypeOfOsmiaLifeStages::to_OsmiaFemale; }
+
+/**
+ * @brief Remove this individual from the spatial output rasters
+ * @details Only the brood stages are counted incrementally (females are copied from the density
+ * grid), so this is a no-op for adults.
+ */
+void Osmia_Base::RemoveFromRaster()
+{
+	TTypeOfOsmiaLifeStages stage = GetStage();
+	if (stage == TTypeOfOsmiaLifeStages::to_OsmiaFemale) return;
+	m_OurPopulationManager->RasterAdd(unsigned(stage), m_Location_x, m_Location_y, -1);
 }
+
 //===========================================================================
 // OSMIA_EGG CLASS IMPLEMENTATION
 //===========================================================================
@@ -1623,7 +1932,7 @@ void Osmia_Egg::ReInit(struct_Osmia* data) {
  * day and handles transitions between development, hatching, and death.
  * 
  * @par State Machine Logic
- * - **toOsmias_InitialState**: Entry point, transitions immediately to Develop
+ * - **toOsmias_InitialState**: Entry point, falls straight through to Develop in the same call
  * - **toOsmias_Develop**: Accumulates degree-days, checks mortality, may transition to NextStage
  * - **toOsmias_NextStage**: Triggers hatching via st_Hatch(), creating larva object
  * - **toOsmias_Die**: Executes death, removes from nest and simulation
@@ -1644,11 +1953,11 @@ void Osmia_Egg::Step(void)
 	if (m_StepDone || m_CurrentStateNo == -1) return;
 	switch (m_CurrentOState)
 	{
-	case toOsmias_InitialState: // Initial state always starts with develop
+	case toOsmias_InitialState: // Initial state always starts with develop, in the same call
 		m_CurrentOState = toOsmias_Develop;
-		break;
+		[[fallthrough]];
 	case toOsmias_Develop:
-		m_CurrentOState = st_Develop();
+		m_CurrentOState = st_Develop(m_Environment);
 		m_StepDone = true;
 		break;
 	case toOsmias_NextStage:
@@ -1680,11 +1989,12 @@ void Osmia_Egg::Step(void)
  * pesticide mortality if the egg was contaminated during oviposition or nest provisioning.
  * 
  * @par Implementation Details
- * Development and mortality only occur when the nest is sealed (GetIsOpen() returns false).
+ * Development and mortality only occur when the nest is sealed (IsNestSealed(), which stops
+ * reading the nest once it has been seen sealed).
  * Unsealed nests indicate the mother is still provisioning, during which eggs do not develop
  * (biological realism: development does not commence until the cell is sealed and temperatures
- * stabilize). Temperature is retrieved daily via m_TempToday (set by population manager before
- * agent steps).
+ * stabilize). Today's degree-day increment is read from the daily environment snapshot (set by
+ * the population manager before agent steps), in the row for the nest's microclimate class.
  * 
  * @par Degree-Day Calculation
  * DD = max(0, daily_temperature - threshold)
@@ -1706,32 +2016,25 @@ void Osmia_Egg::Step(void)
  * @see cfg_OsmiaEggDevelThreshold for LDT parameter
  * @see cfg_OsmiaEggDevelTotalDD for SET parameter
  */
-TTypeOfOsmiaState Osmia_Egg::st_Develop(void)
+TTypeOfOsmiaState Osmia_Egg::st_Develop(const OsmiaDailyEnvironment& a_env)
 {
 	/*
 	* Development is preceded by a mortality test, then a day degree calculation is made to determine the development that occured in the last 24 hours.
 	* When enough day degrees are achieved the egg hatches.If it does not hatch then the development behaviour is queued up for the next day.
 	*/
-	if (!m_OurNest->GetIsOpen()){ 
-		if (DailyMortality()) return toOsmias_Die;
-		//killed by pesticide
-		#ifdef __OSMIA_PESTICIDE_ENGINE
-		if(cfg_OsmiaEggThresholdBasedPesticideResponse.value()){
-			if (g_rand_uni_fnc()<m_egg_pest_mortality){
-				return toOsmias_Die;
-			}
-			else{
-				m_egg_pest_mortality = 0; //only die ones, otherwise set it to 0
-			}
-		}
-		
-		#endif
+	// Random draws are made in the same order and under the same conditions as before
+	bool sealed = IsNestSealed();
+	bool died = sealed && DailyMortality();
+	#ifdef __OSMIA_PESTICIDE_ENGINE
+	//killed by pesticide
+	if (sealed && !died && cfg_OsmiaEggThresholdBasedPesticideResponse.value()){
+		if (g_rand_uni_fnc()<m_egg_pest_mortality) died = true;
+		else m_egg_pest_mortality = 0; //only die ones, otherwise set it to 0
 	}
+	#endif
 	m_Age++;
-	double DD = m_TempToday- m_OsmiaEggDevelThreshold;
-	if (DD > 0) m_AgeDegrees += DD;
-	if (m_AgeDegrees > m_OsmiaEggDevelTotalDD) return toOsmias_NextStage;
-	return toOsmias_Develop;
+	m_AgeDegrees += a_env.m_ClassEggDD[m_Species][m_MicroclimateClass];
+	return m_DevelopOutcome[died][m_AgeDegrees > Traits().m_EggDevelTotalDD];
 }
 
 /**
@@ -1775,6 +2078,10 @@ TTypeOfOsmiaState Osmia_Egg::st_Hatch(void)
 	sO.x = m_Location_x;
 	sO.y = m_Location_y;
 	sO.nest = m_OurNest;
+	sO.nestslot = m_NestSlot;
+#ifdef __OSMIA_LINEAGE
+	sO.lineageid = m_LineageID;
+#endif
 	sO.parasitised = m_ParasitoidStatus;
 	sO.mass = m_Mass;
 	sO.sex = m_Sex;
@@ -1849,7 +2156,7 @@ Osmia_Larva::Osmia_Larva(struct_Osmia* data) : Osmia_Egg(data)
  * parallels egg behaviour but transitions to prepupa rather than larva.
  * 
  * @par State Machine Logic
- * - **toOsmias_InitialState**: Entry point, transitions immediately to Develop
+ * - **toOsmias_InitialState**: Entry point, falls straight through to Develop in the same call
  * - **toOsmias_Develop**: Accumulates degree-days through feeding instars, checks mortality
  * - **toOsmias_NextStage**: Triggers prepupation via st_Prepupate(), creating prepupa object
  * - **toOsmias_Die**: Executes death, removes from nest and simulation
@@ -1871,11 +2178,11 @@ void Osmia_Larva::Step(void)
 	if (m_StepDone || m_CurrentStateNo == -1) return;
 	switch (m_CurrentOState)
 	{
-	case toOsmias_InitialState: // Initial state always starts with develop
+	case toOsmias_InitialState: // Initial state always starts with develop, in the same call
 		m_CurrentOState = toOsmias_Develop;
-		break;
+		[[fallthrough]];
 	case toOsmias_Develop:
-		m_CurrentOState = st_Develop(); 
+		m_CurrentOState = st_Develop(m_Environment); 
 		m_StepDone = true;
 		break;
 	case toOsmias_NextStage:
@@ -1907,9 +2214,9 @@ void Osmia_Larva::Step(void)
  * provisioning), as unsealed cells may have temperature fluctuations or incomplete provisions.
  * 
  * @par Implementation Details
- * Temperature retrieval uses m_OurLandscape->SupplyTemp() to get current daily temperature. This
- * differs slightly from eggs which use m_TempToday, but both access the same underlying temperature
- * data. The degree-day calculation is identical to eggs: DD = max(0, temperature - threshold).
+ * The increment is read from the daily environment snapshot for the nest's microclimate class,
+ * as for eggs, rather than computed from a landscape query by every larva. The degree-day calculation is identical to eggs:
+ * DD = max(0, temperature - threshold).
  * 
  * @par Mortality
  * Daily mortality check occurs only in sealed nests. Unsealed nests represent active provisioning
@@ -1933,15 +2240,12 @@ void Osmia_Larva::Step(void)
  * @see cfg_OsmiaLarvaDevelThreshold for LDT parameter (4.5°C)
  * @see cfg_OsmiaLarvaDevelTotalDD for SET parameter (422 DD)
  */
-TTypeOfOsmiaState Osmia_Larva::st_Develop(void)
+TTypeOfOsmiaState Osmia_Larva::st_Develop(const OsmiaDailyEnvironment& a_env)
 {
-	if (!m_OurNest->GetIsOpen())
-		if (DailyMortality()) return toOsmias_Die;
+	bool died = IsNestSealed() && DailyMortality();
 	m_Age++;
-	double DD = m_OurLandscape->SupplyTemp() - m_OsmiaLarvaDevelThreshold;
-	if (DD > 0) m_AgeDegrees += DD;
-	if (m_AgeDegrees > m_OsmiaLarvaDevelTotalDD) return toOsmias_NextStage;
-	return toOsmias_Develop;
+	m_AgeDegrees += a_env.m_ClassLarvaDD[m_Species][m_MicroclimateClass];
+	return m_DevelopOutcome[died][m_AgeDegrees > Traits().m_LarvaDevelTotalDD];
 }
 
 /**
@@ -1982,6 +2286,10 @@ TTypeOfOsmiaState Osmia_Larva::st_Prepupate(void)
 	sO.x = m_Location_x;
 	sO.y = m_Location_y;
 	sO.nest = m_OurNest;
+	sO.nestslot = m_NestSlot;
+#ifdef __OSMIA_LINEAGE
+	sO.lineageid = m_LineageID;
+#endif
 	sO.mass = m_Mass;
 	sO.parasitised = m_ParasitoidStatus;
 	sO.sex = m_Sex;
@@ -2061,8 +2369,9 @@ Osmia_Prepupa::Osmia_Prepupa(struct_Osmia* data) : Osmia_Larva(data)
 {
 	ReInit(data);
 	m_AgeDegrees = 0;
-	double max20pct = (m_OsmiaPrepupalDevelTotalDays * 0.2 * g_rand_uni_fnc());
-	m_myOsmiaPrepupaDevelTotalDays = m_OsmiaPrepupalDevelTotalDays + max20pct - m_OsmiaPrepupalDevelTotalDays10pct;
+	const double meandays = Traits().m_PrepupaDevelTotalDays;
+	double max20pct = (meandays * 0.2 * g_rand_uni_fnc());
+	m_myOsmiaPrepupaDevelTotalDays = meandays + max20pct - meandays * 0.1;
 }
 
 /**
@@ -2072,7 +2381,7 @@ Osmia_Prepupa::Osmia_Prepupa(struct_Osmia* data) : Osmia_Larva(data)
  * pupation occurs.
  * 
  * @par State Machine Logic
- * - **toOsmias_InitialState**: Entry point, transitions immediately to Develop
+ * - **toOsmias_InitialState**: Entry point, falls straight through to Develop in the same call
  * - **toOsmias_Develop**: Increments age/days, checks mortality, may transition to NextStage
  * - **toOsmias_NextStage**: Triggers pupation via st_Pupate(), creating pupa object
  * - **toOsmias_Die**: Executes death, removes from nest and simulation
@@ -2095,11 +2404,11 @@ void Osmia_Prepupa::Step(void)
 	if (m_StepDone || m_CurrentStateNo == -1) return;
 	switch (m_CurrentOState)
 	{
-	case toOsmias_InitialState: // Initial state always starts with develop
+	case toOsmias_InitialState: // Initial state always starts with develop, in the same call
 		m_CurrentOState = toOsmias_Develop;
-		break;
+		[[fallthrough]];
 	case toOsmias_Develop:
-		m_CurrentOState = st_Develop();
+		m_CurrentOState = st_Develop(m_Environment);
 		m_StepDone = true;
 		break;
 	case toOsmias_NextStage:
@@ -2131,8 +2440,8 @@ void Osmia_Prepupa::Step(void)
  * physiological demands of this transitional stage.
  * 
  * @par Implementation Details
- * The population manager provides a daily "developmental days" increment via GetPrePupalDevelDays(),
- * which typically returns 1.0 but could implement temperature-modification if desired. The variable
+ * The population manager provides a daily "developmental days" increment in the daily environment
+ * snapshot (the value GetPrePupalDevelDays() returns), which typically returns 1.0 but could implement temperature-modification if desired. The variable
  * m_AgeDegrees (misnomer, actually counts days) increments with this value. When this counter
  * exceeds the individual's m_myOsmiaPrepupaDevelTotalDays, pupation occurs.
  * 
@@ -2161,18 +2470,17 @@ void Osmia_Prepupa::Step(void)
  * @see cfg_OsmiaPrepupaDevelTotalDays for mean duration parameter (45 days)
  * @see Constructor for individual variation implementation
  */
-TTypeOfOsmiaState Osmia_Prepupa::st_Develop(void)
+TTypeOfOsmiaState Osmia_Prepupa::st_Develop(const OsmiaDailyEnvironment& a_env)
 {
 	/** 
 	* Development occurs if the prepupa does not die of non-specified causes. Temperature drives the basic development
 	* towards a target m_myOsmiaPrepupaDevelTotalDays. This has individual variation built in around a mean value.
 	*/
-	if (DailyMortality()) return toOsmias_Die;
+	bool died = DailyMortality();
 	// Get the temperature dependent development
 	m_Age++;
-	m_AgeDegrees += m_OurPopulationManager->GetPrePupalDevelDays();
-	if (m_AgeDegrees++ > m_myOsmiaPrepupaDevelTotalDays) return toOsmias_NextStage; 
-	return toOsmias_Develop;
+	m_AgeDegrees += a_env.m_ClassPrePupaDays[m_MicroclimateClass];
+	return m_DevelopOutcome[died][m_AgeDegrees++ > m_myOsmiaPrepupaDevelTotalDays];
 }
 
 /**
@@ -2215,6 +2523,10 @@ TTypeOfOsmiaState Osmia_Prepupa::st_Pupate(void)
 	sO.x = m_Location_x;
 	sO.y = m_Location_y;
 	sO.nest = m_OurNest;
+	sO.nestslot = m_NestSlot;
+#ifdef __OSMIA_LINEAGE
+	sO.lineageid = m_LineageID;
+#endif
 	sO.mass = m_Mass;
 	sO.parasitised = m_ParasitoidStatus;
 	sO.sex = m_Sex;
@@ -2294,7 +2606,7 @@ Osmia_Pupa::Osmia_Pupa(struct_Osmia* data) : Osmia_Prepupa(data)
  * overwintering adult (Osmia_InCocoon) occurs.
  * 
  * @par State Machine Logic
- * - **toOsmias_InitialState**: Entry point, transitions immediately to Develop
+ * - **toOsmias_InitialState**: Entry point, falls straight through to Develop in the same call
  * - **toOsmias_Develop**: Accumulates degree-days through metamorphosis, checks mortality
  * - **toOsmias_NextStage**: Triggers emergence via st_Emerge(), creating InCocoon object
  * - **toOsmias_Die**: Executes death, removes from nest and simulation
@@ -2324,11 +2636,11 @@ void Osmia_Pupa::Step(void)
 	if (m_StepDone || m_CurrentStateNo == -1) return;
 	switch (m_CurrentOState)
 	{
-	case toOsmias_InitialState: // Initial state always starts with develop
+	case toOsmias_InitialState: // Initial state always starts with develop, in the same call
 		m_CurrentOState = toOsmias_Develop;
-		break;
+		[[fallthrough]];
 	case toOsmias_Develop:
-		m_CurrentOState = st_Develop(); 
+		m_CurrentOState = st_Develop(m_Environment); 
 		m_StepDone = true;
 		break;
 	case toOsmias_NextStage:
@@ -2363,7 +2675,8 @@ void Osmia_Pupa::Step(void)
  * @par Implementation Details
  * The degree-day calculation is standard: DD = max(0, temperature - threshold). Only positive
  * values accumulate; temperatures below threshold cause developmental pause without regression.
- * Temperature retrieval uses SupplyTemp() from the landscape, providing daily ambient conditions.
+ * The increment is read from the daily environment snapshot built by the population manager, in
+ * the row for the nest's microclimate class.
  * 
  * @par Critical Timing Considerations
  * The timing of pupal development completion determines whether individuals overwinter successfully.
@@ -2402,17 +2715,12 @@ void Osmia_Pupa::Step(void)
  * @see cfg_OsmiaPupaDevelThreshold for LDT parameter (1.1°C, down from 13.2°C)
  * @see cfg_OsmiaPupaDevelTotalDD for SET parameter (570 DD, up from 272.3 DD)
  */
-TTypeOfOsmiaState Osmia_Pupa::st_Develop(void)
+TTypeOfOsmiaState Osmia_Pupa::st_Develop(const OsmiaDailyEnvironment& a_env)
 {
-	if (DailyMortality()) return toOsmias_Die;
+	bool died = DailyMortality();
 	m_Age++;
-	double DD = m_OurLandscape->SupplyTemp() - m_OsmiaPupaDevelThreshold;
-	if (DD > 0) m_AgeDegrees += DD;
-	if (m_AgeDegrees > m_OsmiaPupaDevelTotalDD)
-	{
-		return toOsmias_NextStage;
-	}
-	return toOsmias_Develop;
+	m_AgeDegrees += a_env.m_ClassPupaDD[m_Species][m_MicroclimateClass];
+	return m_DevelopOutcome[died][m_AgeDegrees > Traits().m_PupaDevelTotalDD];
 }
 
 /**
@@ -2464,6 +2772,10 @@ TTypeOfOsmiaState Osmia_Pupa::st_Emerge(void)
 	sO.x = m_Location_x;
 	sO.y = m_Location_y;
 	sO.nest = m_OurNest;
+	sO.nestslot = m_NestSlot;
+#ifdef __OSMIA_LINEAGE
+	sO.lineageid = m_LineageID;
+#endif
 	sO.parasitised = m_ParasitoidStatus;
 	sO.mass = m_Mass;
 	sO.sex = m_Sex;
@@ -2564,7 +2876,7 @@ Osmia_InCocoon::Osmia_InCocoon(struct_Osmia* data) : Osmia_Pupa(data)
  * spring emergence conditions are met.
  * 
  * @par State Machine Logic
- * - **toOsmias_InitialState**: Entry point, transitions immediately to Develop
+ * - **toOsmias_InitialState**: Entry point, falls straight through to Develop in the same call
  * - **toOsmias_Develop**: Progresses through overwintering phases, accumulates degree-days/emergence counter
  * - **toOsmias_NextStage**: Triggers spring emergence via st_Emerge(), creating active adult
  * - **toOsmias_Die**: Executes death from winter mortality or emergence failure
@@ -2592,11 +2904,11 @@ void Osmia_InCocoon::Step(void)
 	if (m_StepDone || m_CurrentStateNo == -1) return;
 	switch (m_CurrentOState)
 	{
-	case toOsmias_InitialState: // Initial state always starts with develop
+	case toOsmias_InitialState: // Initial state always starts with develop, in the same call
 		m_CurrentOState = toOsmias_Develop;
-		break;
+		[[fallthrough]];
 	case toOsmias_Develop:
-		m_CurrentOState = st_Develop();
+		m_CurrentOState = st_Develop(m_Environment);
 		m_StepDone = true;
 		break;
 	case toOsmias_NextStage:
@@ -2647,6 +2959,8 @@ void Osmia_InCocoon::Step(void)
  * differences. South-facing nests warm earlier in spring and have shorter delays; north-facing
  * nests experience delayed emergence. This implements realistic phenological variation based on
  * nest-site characteristics.
+ * With OSMIA_MICROCLIMATE on, aspect already sets the nest's microclimate class and so its
+ * temperature, so the delay is not added as well.
  * 
  * @par Late-Season Emergence Deadline
  * If the emergence counter has not reached zero by June 1st, death occurs. This implements the
@@ -2660,9 +2974,9 @@ void Osmia_InCocoon::Step(void)
  * phenological spread across 10-15 days even when emergence conditions are met simultaneously.
  * 
  * @par Implementation Details
- * Phase determination relies on population manager flags (IsEndPreWinter(), IsOverWinterEnd()) that
- * track seasonal transitions. Temperature retrieval uses m_TempToday (set by population manager
- * before agent steps). The complex logic ensures appropriate phase-specific behaviour without
+ * Phase determination relies on the pre-wintering and over-wintering flags copied into the daily
+ * environment snapshot from the population manager (IsEndPreWinter(), IsOverWinterEnd()), which
+ * track seasonal transitions. Temperature and day of year come from the same snapshot. The complex logic ensures appropriate phase-specific behaviour without
  * explicit state variables for phases.
  * 
  * @par Biological Rationale
@@ -2703,7 +3017,7 @@ void Osmia_InCocoon::Step(void)
  * @see WinterMortality() for mortality calculation
  * @see Osmia_Nest::GetAspectDelay() for aspect-based phenological variation
  */
-TTypeOfOsmiaState Osmia_InCocoon::st_Develop(void)
+TTypeOfOsmiaState Osmia_InCocoon::st_Develop(const OsmiaDailyEnvironment& a_env)
 {
 	/**
 	* This is/must be called each day.
@@ -2711,22 +3025,27 @@ TTypeOfOsmiaState Osmia_InCocoon::st_Develop(void)
 	* to end and wintering (hibernation) is assumed to start.
 	* This is recorded by the population manager in Osmia_Population_Manager::DoLast
 	*/
+	// Bombylid kills happen only once emergence has begun; a queued victim stops here
+	if (a_env.m_OverWinterEnded && !m_OurNest->IsCellAlive(m_NestSlot)) return toOsmias_Die;
 	m_Age++;
-	if (m_OurPopulationManager->IsEndPreWinter())
+	const double temp = a_env.m_ClassTemp[m_MicroclimateClass];
+	const OsmiaSpeciesTraits& traits = Traits();
+	if (a_env.m_PreWinteringEnded)
 	{
 		// Must be after pre-wintering
-		if (!m_OurPopulationManager->IsOverWinterEnd())
+		if (!a_env.m_OverWinterEnded)
 		{
 			// The pre-wintering is over, but its not 1st of March yet 
-			double DD = m_TempToday - m_OsmiaInCocoonOverwinteringTempThreshold;
+			double DD = temp - traits.m_InCocoonOverwinteringTempThreshold;
 			if (DD > 0) m_AgeDegrees += DD;
 		}
 		else // It is >= March 1st
 		{
-			if (m_DayInYear == March+1) { // if first day of March
-				m_emergencecounter = int(m_OsmiaInCocoonEmergCountConst + m_OsmiaInCocoonEmergCountSlope * m_AgeDegrees) + m_emergenceday.Geti() + m_OurNest->GetAspectDelay();
+			if (a_env.m_DayInYear == March+1) { // if first day of March
+				m_emergencecounter = int(traits.m_InCocoonEmergCountConst + traits.m_InCocoonEmergCountSlope * m_AgeDegrees) + m_emergenceday.Geti();
+				if (!a_env.m_Microclimate) m_emergencecounter += m_OurNest->GetAspectDelay();
 			}
-			else if (m_TempToday >= m_OsmiaInCocoonEmergenceTempThreshold)
+			else if (temp >= traits.m_InCocoonEmergenceTempThreshold)
 			{
 				if (--m_emergencecounter < 1)
 				{
@@ -2734,7 +3053,7 @@ TTypeOfOsmiaState Osmia_InCocoon::st_Develop(void)
 					else return toOsmias_NextStage;
 				}
 
-				if(m_DayInYear == June-1){//too late to emerge
+				if(a_env.m_DayInYear == June-1){//too late to emerge
 					return toOsmias_Die;
 				}
 			}
@@ -2743,7 +3062,7 @@ TTypeOfOsmiaState Osmia_InCocoon::st_Develop(void)
 	else
 	{
 		// Must be pre-wintering so count up prewintering day degrees
-		if (m_TempToday > m_OsmiaInCocoonPrewinteringTempThreshold) m_DDPrewinter += (m_TempToday - m_OsmiaInCocoonPrewinteringTempThreshold);
+		if (temp > traits.m_InCocoonPrewinteringTempThreshold) m_DDPrewinter += (temp - traits.m_InCocoonPrewinteringTempThreshold);
 	}
 	return toOsmias_Develop;
 }
@@ -2794,6 +3113,11 @@ TTypeOfOsmiaState Osmia_InCocoon::st_Develop(void)
  * behaviour, dispersal, and nest-site selection before establishing their own nest. This reflects
  * the biological reality that *O. bicornis* females do not reuse their natal nest.
  * 
+ * @par Cell Claim
+ * The cell is emptied first with Osmia_Nest::ClaimCell(). If a bombylid emerging from an earlier
+ * cell has already killed this one (the kill is only carried out at the end of the day), the claim
+ * fails and the individual dies instead of emerging.
+ * 
  * @par Model Outputs
  * Records overwintering duration under OSMIATESTING for validation. Given the complexity of
  * overwintering and the calibrations applied to emergence parameters, comparing simulated durations
@@ -2812,6 +3136,8 @@ TTypeOfOsmiaState Osmia_InCocoon::st_Develop(void)
  */
 TTypeOfOsmiaState Osmia_InCocoon::st_Emerge(void)
 {
+	// Leaving empties the cell; if a bombylid from an earlier cell has already killed it, die instead
+	if (!m_OurNest->ClaimCell(m_NestSlot)) return toOsmias_Die;
 	/**
 	* If this is a male (sex == false) we quietly let it vanish, since we do not model adult males.
 	*/
@@ -2825,7 +3151,7 @@ TTypeOfOsmiaState Osmia_InCocoon::st_Emerge(void)
 			/switch (m_ParasitoidStatus)
 			{
 			case TTypeOfOsmiaParasitoids::topara_Bombylid:
-				m_OurNest->KillAllSubsequentCells(this);
+				m_OurNest->KillAllSubsequentCells(m_NestSlot);
 				m_OurParasitoidPopulationManager->AddParasitoid(TTypeOfOsmiaParasitoids::topara_Bombylid, m_Location_x, m_Location_y);
 				break;
 			case TTypeOfOsmiaParasitoids::topara_Cleptoparasite:
@@ -2846,6 +3172,9 @@ TTypeOfOsmiaState Osmia_InCocoon::st_Emerge(void)
 		sO.x = m_Location_x;
 		sO.y = m_Location_y;
 		sO.nest = nullptr; //no nest for females
+#ifdef __OSMIA_LINEAGE
+		sO.lineageid = m_LineageID;
+#endif
 		sO.parasitised = TTypeOfOsmiaParasitoids::topara_Unparasitised;
 		sO.sex = m_Sex;
 		/**
@@ -2858,15 +3187,15 @@ TTypeOfOsmiaState Osmia_InCocoon::st_Emerge(void)
 		* So we can calculate the combination of the two linear relationships to get female mass from provision mass by:
 		* mass = 0.246381*provision_mass + 4.0
 		*/
-		sO.mass = m_OsmiaFemaleMassFromProvMassSlope * m_Mass + m_OsmiaFemaleMassFromProvMassConst;
+		sO.mass = Traits().m_FemaleMassFromProvMassSlope * m_Mass + Traits().m_FemaleMassFromProvMassConst;
 		m_OurPopulationManager->CreateObjects(TTypeOfOsmiaLifeStages::to_OsmiaFemale, this, &sO, 1);
 		#ifdef __OSMIATESTING
 		m_OurPopulationManager->RecordInCocoonLength(m_Age - m_StageAge);
 		#endif
 	}
+	else RemoveFromRaster();  // Males vanish; a female's exit is counted when she is created
 
 	KillThis(); // sets current state to -1 and StepDone to true;
-	m_OurNest->RemoveCell(this);
 	return toOsmias_Emerged; // This is just to have a return value, it is not used
 }
 
@@ -2944,6 +3273,6 @@ bool Osmia_InCocoon::WinterMortality()
 	* with a baseline temperature T0 = 15 C degrees, and only for days when Tavg – T0 >= 0
 	*/
 	//std::cout<<m_OsmiaInCocoonWinterMortSlope * m_DDPrewinter + m_OsmiaInCocoonWinterMortConst<<std::endl;
-	if (g_random_fnc(100) < (m_OsmiaInCocoonWinterMortSlope * m_DDPrewinter + m_OsmiaInCocoonWinterMortConst)) return true;
+	if (g_random_fnc(100) < (Traits().m_InCocoonWinterMortSlope * m_DDPrewinter + Traits().m_InCocoonWinterMortConst)) return true;
 	else return false;
 }